@@ -3,8 +3,35 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Função para carregar a agenda de limites de escrita ({"start": "HH:MM", "end": "HH:MM", ...})
+static void load_rate_schedule(Config *config, struct json_object *array) {
+    size_t length = json_object_array_length(array);
+    if (length == 0) return;
+    config->rate_schedule = calloc(length, sizeof(RateWindow));
+    if (!config->rate_schedule) return;
+
+    for (size_t i = 0; i < length; i++) {
+        struct json_object *entry = json_object_array_get_idx(array, i);
+        struct json_object *value;
+        RateWindow window = {0};
+        window.start_minute = json_object_object_get_ex(entry, "start", &value)
+            ? rate_limiter_parse_time(json_object_get_string(value)) : -1;
+        window.end_minute = json_object_object_get_ex(entry, "end", &value)
+            ? rate_limiter_parse_time(json_object_get_string(value)) : -1;
+        if (window.start_minute < 0 || window.end_minute < 0) {
+            fprintf(stderr, "Janela %zu de rate_schedule ignorada: use \"start\" e \"end\" no formato HH:MM\n", i);
+            continue;
+        }
+        if (json_object_object_get_ex(entry, "docs_per_sec", &value))
+            window.docs_per_sec = (long)json_object_get_int64(value);
+        if (json_object_object_get_ex(entry, "bytes_per_sec", &value))
+            window.bytes_per_sec = (long)json_object_get_int64(value);
+        config->rate_schedule[config->rate_schedule_count++] = window;
+    }
+}
+
 Config* load_config(const char *config_file) {
-    Config *config = (Config*)malloc(sizeof(Config));
+    Config *config = (Config*)calloc(1, sizeof(Config));
     if (!config) {
         fprintf(stderr, "Erro ao alocar memória para configurações\n");
         return NULL;
@@ -13,6 +40,31 @@ Config* load_config(const char *config_file) {
     // Valores padrão
     config->max_threads = 8;
     config->memory_limit_percent = 70;
+    config->thread_pinning = false;
+    config->numa_local_memory = false;
+    config->numa_spread = false;
+    config->trace_file = NULL;
+    config->trace_window_start = 0;
+    config->trace_window_batches = 100;
+    config->io_backend = NULL;
+    config->io_direct = false;
+    config->io_queue_depth = 4;
+    config->io_block_size_kb = 1024;
+    config->incremental = false;
+    config->state_dir = strdup("state");
+    config->batch_size = 1000;
+    config->shard_routing = false;
+    config->shard_direct_connections = false;
+    config->stream_buffer_mb = 8;
+    config->stream_queue_chunks = 16;
+    config->steal_chunk_mb = 32;
+    config->input_encoding = NULL;
+    config->verify = false;
+    config->rejects_dir = strdup("rejects");
+    config->rate_docs_per_sec = 0;
+    config->rate_bytes_per_sec = 0;
+    config->rate_schedule = NULL;
+    config->rate_schedule_count = 0;
 
     // Carrega o arquivo JSON
     struct json_object *json;
@@ -38,6 +90,71 @@ Config* load_config(const char *config_file) {
     if (json_object_object_get_ex(json, "mongodb_password", &tmp))
         config->mongodb_password = strdup(json_object_get_string(tmp));
 
+    // Posicionamento das threads (CPU/NUMA)
+    if (json_object_object_get_ex(json, "thread_pinning", &tmp))
+        config->thread_pinning = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "numa_local_memory", &tmp))
+        config->numa_local_memory = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "numa_spread", &tmp))
+        config->numa_spread = json_object_get_boolean(tmp);
+
+    // Trace do caminho crítico (só tem efeito quando compilado com TRACE=1)
+    if (json_object_object_get_ex(json, "trace_file", &tmp))
+        config->trace_file = strdup(json_object_get_string(tmp));
+    if (json_object_object_get_ex(json, "trace_window_start", &tmp))
+        config->trace_window_start = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "trace_window_batches", &tmp))
+        config->trace_window_batches = json_object_get_int(tmp);
+
+    // Leitura dos arquivos CSV
+    if (json_object_object_get_ex(json, "io_backend", &tmp))
+        config->io_backend = strdup(json_object_get_string(tmp));
+    if (json_object_object_get_ex(json, "io_direct", &tmp))
+        config->io_direct = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "io_queue_depth", &tmp))
+        config->io_queue_depth = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "io_block_size_kb", &tmp))
+        config->io_block_size_kb = json_object_get_int(tmp);
+
+    // Importação incremental e escritas em lote
+    if (json_object_object_get_ex(json, "incremental", &tmp))
+        config->incremental = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "state_dir", &tmp)) {
+        free(config->state_dir);
+        config->state_dir = strdup(json_object_get_string(tmp));
+    }
+    if (json_object_object_get_ex(json, "batch_size", &tmp))
+        config->batch_size = json_object_get_int(tmp);
+
+    // Roteamento de escritas por shard
+    if (json_object_object_get_ex(json, "shard_routing", &tmp))
+        config->shard_routing = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "shard_direct_connections", &tmp))
+        config->shard_direct_connections = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "max_threads", &tmp))
+        config->max_threads = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "stream_buffer_mb", &tmp))
+        config->stream_buffer_mb = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "stream_queue_chunks", &tmp))
+        config->stream_queue_chunks = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "steal_chunk_mb", &tmp))
+        config->steal_chunk_mb = json_object_get_int(tmp);
+    if (json_object_object_get_ex(json, "input_encoding", &tmp))
+        config->input_encoding = strdup(json_object_get_string(tmp));
+    if (json_object_object_get_ex(json, "verify", &tmp))
+        config->verify = json_object_get_boolean(tmp);
+    if (json_object_object_get_ex(json, "rejects_dir", &tmp)) {
+        free(config->rejects_dir);
+        config->rejects_dir = strdup(json_object_get_string(tmp));
+    }
+
+    if (json_object_object_get_ex(json, "rate_docs_per_sec", &tmp))
+        config->rate_docs_per_sec = (long)json_object_get_int64(tmp);
+    if (json_object_object_get_ex(json, "rate_bytes_per_sec", &tmp))
+        config->rate_bytes_per_sec = (long)json_object_get_int64(tmp);
+    if (json_object_object_get_ex(json, "rate_schedule", &tmp) && json_object_is_type(tmp, json_type_array))
+        load_rate_schedule(config, tmp);
+
     json_object_put(json);
     return config;
 }
@@ -50,5 +167,11 @@ void free_config(Config *config) {
     free(config->mongodb_collection);
     free(config->mongodb_username);
     free(config->mongodb_password);
+    free(config->trace_file);
+    free(config->io_backend);
+    free(config->input_encoding);
+    free(config->state_dir);
+    free(config->rejects_dir);
+    free(config->rate_schedule);
     free(config);
 } 
\ No newline at end of file
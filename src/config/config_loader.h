@@ -2,6 +2,8 @@
 #define CONFIG_LOADER_H
 
 #include <json-c/json.h>
+#include <stdbool.h>
+#include "../mongodb/rate_limiter.h"
 
 typedef struct {
     char *mongodb_host;
@@ -12,6 +14,31 @@ typedef struct {
     char *mongodb_password;
     int max_threads;
     int memory_limit_percent;
+    bool thread_pinning;
+    bool numa_local_memory;
+    bool numa_spread;
+    char *trace_file;
+    int trace_window_start;
+    int trace_window_batches;
+    char *io_backend;
+    bool io_direct;
+    int io_queue_depth;
+    int io_block_size_kb;
+    bool incremental;
+    char *state_dir;
+    int batch_size;
+    bool shard_routing;
+    bool shard_direct_connections;
+    int stream_buffer_mb;       // Tamanho de cada bloco lido de stdin/pipe
+    int stream_queue_chunks;    // Blocos aguardando os workers
+    int steal_chunk_mb;         // Trechos roubados por workers ociosos; 0 = sem roubo
+    char *input_encoding;       // utf-8, latin1 ou windows-1252
+    bool verify;                // Compara digests da importação com a coleção
+    char *rejects_dir;          // Quarentena das linhas rejeitadas
+    long rate_docs_per_sec;     // Limite global de escrita; 0 = sem limite
+    long rate_bytes_per_sec;
+    RateWindow *rate_schedule;  // Janelas do dia com limites próprios
+    int rate_schedule_count;
 } Config;
 
 // Carrega as configurações do arquivo config.json
@@ -0,0 +1,430 @@
+#define _GNU_SOURCE
+#include "file_reader.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#define READER_ALIGNMENT 4096
+#define DEFAULT_QUEUE_DEPTH 4
+#define DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+// Um buffer de leitura; os buffers formam um anel consumido em ordem
+typedef struct {
+    char *data;
+    off_t offset;      // Posição do bloco no arquivo
+    size_t length;     // Bytes válidos após a conclusão
+    bool pending;      // Leitura submetida e ainda não concluída
+    bool in_ring;      // Leitura foi submetida ao io_uring
+    bool reaped;       // Resultado veio do io_uring e ainda pode ser uma leitura curta
+    bool submitted;    // Bloco pertence ao arquivo (offset < tamanho)
+    int result;        // Resultado da leitura (bytes ou -errno)
+} ReadSlot;
+
+struct FileReader {
+    int fd;
+    bool use_uring;
+    bool direct_io;
+    off_t file_size;
+    off_t next_offset;     // Próximo bloco a ser submetido
+    size_t block_size;
+    int slot_count;
+    ReadSlot *slots;
+    int current;           // Slot sendo consumido
+    size_t position;       // Posição de leitura dentro do slot atual
+    bool current_ready;
+    char *line;            // Linha que atravessa a fronteira entre blocos
+    size_t line_capacity;
+    off_t line_offset;     // Offset no arquivo do início da próxima linha
+    off_t range_end;       // Linhas que começam a partir daqui não são retornadas
+    size_t start_skip;     // Bytes a descartar no primeiro bloco após reposicionar
+    bool discard_partial;  // Descarta até a primeira quebra (linha do trecho anterior)
+    bool failed;           // Erro de leitura ou sem memória para a linha
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+#endif
+};
+
+ReaderBackend file_reader_parse_backend(const char *name) {
+    if (!name || strcmp(name, "auto") == 0) return READER_BACKEND_AUTO;
+    if (strcmp(name, "io_uring") == 0) return READER_BACKEND_URING;
+    if (strcmp(name, "pread") == 0) return READER_BACKEND_PREAD;
+    logger_log(LOG_WARNING, "Backend de leitura desconhecido '%s', usando auto", name);
+    return READER_BACKEND_AUTO;
+}
+
+const char* file_reader_backend_name(const FileReader *reader) {
+    if (!reader) return "nenhum";
+    if (reader->use_uring) return reader->direct_io ? "io_uring+O_DIRECT" : "io_uring";
+    return reader->direct_io ? "pread+O_DIRECT" : "pread";
+}
+
+// Desliga o O_DIRECT do descritor: uma leitura curta no meio do arquivo
+// deixaria a continuação com offset e tamanho desalinhados
+static bool disable_direct_io(FileReader *reader, off_t offset) {
+    int flags = fcntl(reader->fd, F_GETFL);
+    if (flags < 0 || fcntl(reader->fd, F_SETFL, flags & ~O_DIRECT) < 0) {
+        logger_log(LOG_ERROR, "Leitura curta desalinhada no offset %lld e O_DIRECT não pôde ser desligado: %s",
+            (long long)offset, strerror(errno));
+        return false;
+    }
+    reader->direct_io = false;
+    logger_log(LOG_WARNING, "Leitura curta desalinhada no offset %lld: usando leitura com cache", (long long)offset);
+    return true;
+}
+
+// Lê de forma síncrona o que faltar do bloco (leituras curtas ou backend pread)
+static int read_rest(FileReader *reader, ReadSlot *slot, size_t done) {
+    size_t wanted = reader->block_size;
+    if ((off_t)(slot->offset + wanted) > reader->file_size) {
+        wanted = (size_t)(reader->file_size - slot->offset);
+    }
+
+    while (done < wanted) {
+        if (reader->direct_io && (done & (READER_ALIGNMENT - 1)) != 0 &&
+            !disable_direct_io(reader, slot->offset + (off_t)done)) {
+            return -EINVAL;
+        }
+        // Com O_DIRECT o tamanho pedido precisa continuar alinhado
+        size_t request = reader->direct_io ? reader->block_size - done : wanted - done;
+        ssize_t n = pread(reader->fd, slot->data + done, request, slot->offset + (off_t)done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
+    }
+    return (int)(done < wanted ? done : wanted);
+}
+
+// Agenda a leitura do próximo bloco do arquivo no slot informado
+static void submit_slot(FileReader *reader, int index) {
+    ReadSlot *slot = &reader->slots[index];
+    slot->submitted = false;
+    slot->pending = false;
+    slot->in_ring = false;
+    slot->reaped = false;
+    slot->length = 0;
+    if (reader->next_offset >= reader->file_size) return;
+
+    slot->offset = reader->next_offset;
+    reader->next_offset += (off_t)reader->block_size;
+    slot->submitted = true;
+
+#ifdef HAVE_LIBURING
+    if (reader->use_uring) {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&reader->ring);
+        if (sqe) {
+            io_uring_prep_read(sqe, reader->fd, slot->data, (unsigned)reader->block_size, (unsigned long long)slot->offset);
+            io_uring_sqe_set_data(sqe, (void*)(uintptr_t)index);
+            slot->pending = true;
+            slot->in_ring = true;
+            io_uring_submit(&reader->ring);
+            return;
+        }
+    }
+#endif
+
+    // pread: o kernel já foi avisado para ler a janela à frente (WILLNEED)
+    off_t ahead = slot->offset + (off_t)reader->block_size;
+    posix_fadvise(reader->fd, ahead, (off_t)(reader->block_size * reader->slot_count), POSIX_FADV_WILLNEED);
+    slot->pending = true;
+    slot->result = -EAGAIN;
+}
+
+// Aguarda a conclusão do slot atual
+static bool wait_slot(FileReader *reader, ReadSlot *slot) {
+#ifdef HAVE_LIBURING
+    // Conclusões de outros slots também são colhidas aqui; cada uma fica
+    // marcada para ser completada quando o seu slot for consumido
+    while (slot->in_ring) {
+        struct io_uring_cqe *cqe;
+        int rc = io_uring_wait_cqe(&reader->ring, &cqe);
+        if (rc < 0) {
+            if (rc == -EINTR) continue;
+            logger_log(LOG_ERROR, "Erro aguardando io_uring: %s", strerror(-rc));
+            return false;
+        }
+        int index = (int)(uintptr_t)io_uring_cqe_get_data(cqe);
+        reader->slots[index].result = cqe->res;
+        reader->slots[index].pending = false;
+        reader->slots[index].in_ring = false;
+        reader->slots[index].reaped = true;
+        io_uring_cqe_seen(&reader->ring, cqe);
+    }
+#endif
+
+    // Completa leituras curtas antes do fim do arquivo
+    if (slot->reaped) {
+        slot->reaped = false;
+        if (slot->result >= 0) slot->result = read_rest(reader, slot, (size_t)slot->result);
+    }
+
+    if (slot->pending) {
+        slot->result = read_rest(reader, slot, 0);
+        slot->pending = false;
+    }
+
+    if (slot->result < 0) {
+        logger_log(LOG_ERROR, "Erro de leitura no offset %lld: %s", (long long)slot->offset, strerror(-slot->result));
+        return false;
+    }
+    slot->length = (size_t)slot->result;
+    return true;
+}
+
+// Aguarda as leituras ainda em voo, cujos buffers serão reaproveitados ou liberados
+static void drain_ring(FileReader *reader) {
+#ifdef HAVE_LIBURING
+    for (int i = 0; reader->slots && i < reader->slot_count; i++) {
+        while (reader->slots[i].in_ring) {
+            struct io_uring_cqe *cqe;
+            if (io_uring_wait_cqe(&reader->ring, &cqe) < 0) break;
+            int index = (int)(uintptr_t)io_uring_cqe_get_data(cqe);
+            reader->slots[index].pending = false;
+            reader->slots[index].in_ring = false;
+            io_uring_cqe_seen(&reader->ring, cqe);
+        }
+    }
+#else
+    (void)reader;
+#endif
+}
+
+// Reposiciona a leitura para as linhas que começam em `start`: lê a partir
+// do byte anterior (alinhado para O_DIRECT) e descarta até a primeira quebra
+static void seek_line(FileReader *reader, off_t start) {
+    drain_ring(reader);
+
+    off_t from = start > 0 ? start - 1 : 0;
+    off_t aligned = from & ~(off_t)(READER_ALIGNMENT - 1);
+    reader->next_offset = aligned;
+    reader->start_skip = (size_t)(from - aligned);
+    reader->discard_partial = start > 0;
+    reader->line_offset = start;
+    reader->current = 0;
+    reader->current_ready = false;
+    reader->position = 0;
+
+    for (int i = 0; i < reader->slot_count; i++) {
+        submit_slot(reader, i);
+    }
+}
+
+static bool ensure_line_capacity(FileReader *reader, size_t needed) {
+    if (needed <= reader->line_capacity) return true;
+    size_t capacity = reader->line_capacity ? reader->line_capacity : 4096;
+    while (capacity < needed) capacity *= 2;
+    char *line = realloc(reader->line, capacity);
+    if (!line) return false;
+    reader->line = line;
+    reader->line_capacity = capacity;
+    return true;
+}
+
+FileReader* file_reader_open(const char *path, const FileReaderConfig *config) {
+    return file_reader_open_range(path, config, 0, -1);
+}
+
+FileReader* file_reader_open_range(const char *path, const FileReaderConfig *config, off_t start, off_t end) {
+    FileReaderConfig defaults = { READER_BACKEND_AUTO, false, DEFAULT_QUEUE_DEPTH, DEFAULT_BLOCK_SIZE };
+    if (!config) config = &defaults;
+
+    FileReader *reader = calloc(1, sizeof(FileReader));
+    if (!reader) return NULL;
+
+    reader->slot_count = config->queue_depth > 0 ? config->queue_depth : DEFAULT_QUEUE_DEPTH;
+    reader->block_size = config->block_size >= READER_ALIGNMENT ? config->block_size : DEFAULT_BLOCK_SIZE;
+    reader->block_size = (reader->block_size + READER_ALIGNMENT - 1) & ~(size_t)(READER_ALIGNMENT - 1);
+
+    // O_DIRECT não é suportado por todos os sistemas de arquivos (ex.: tmpfs)
+    reader->fd = -1;
+    if (config->direct_io) {
+        reader->fd = open(path, O_RDONLY | O_DIRECT);
+        if (reader->fd >= 0) {
+            reader->direct_io = true;
+        } else {
+            logger_log(LOG_WARNING, "O_DIRECT indisponível para %s (%s), usando leitura com cache", path, strerror(errno));
+        }
+    }
+    if (reader->fd < 0) reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) {
+        free(reader);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0) {
+        close(reader->fd);
+        free(reader);
+        return NULL;
+    }
+    reader->file_size = st.st_size;
+    if (!reader->direct_io) {
+        posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    reader->slots = calloc(reader->slot_count, sizeof(ReadSlot));
+    if (!reader->slots) {
+        file_reader_close(reader);
+        return NULL;
+    }
+    for (int i = 0; i < reader->slot_count; i++) {
+        if (posix_memalign((void**)&reader->slots[i].data, READER_ALIGNMENT, reader->block_size) != 0) {
+            reader->slots[i].data = NULL;
+            file_reader_close(reader);
+            return NULL;
+        }
+    }
+
+#ifdef HAVE_LIBURING
+    if (config->backend != READER_BACKEND_PREAD) {
+        int rc = io_uring_queue_init((unsigned)reader->slot_count, &reader->ring, 0);
+        if (rc == 0) {
+            reader->use_uring = true;
+        } else {
+            logger_log(LOG_WARNING, "io_uring indisponível (%s), usando pread", strerror(-rc));
+        }
+    }
+#else
+    if (config->backend == READER_BACKEND_URING) {
+        logger_log(LOG_WARNING, "Compilado sem liburing, usando pread");
+    }
+#endif
+
+    reader->range_end = end >= 0 && end < reader->file_size ? end : reader->file_size;
+    seek_line(reader, start);
+    return reader;
+}
+
+bool file_reader_set_range(FileReader *reader, off_t start, off_t end) {
+    if (!reader) return false;
+    if (end < 0 || end > reader->file_size) end = reader->file_size;
+
+    // Trecho seguinte ao atual: a próxima linha já é a primeira do novo trecho
+    bool contiguous = start == reader->line_offset ||
+                      (start == reader->range_end && reader->line_offset >= start && !reader->discard_partial);
+    if (!contiguous) seek_line(reader, start);
+    reader->range_end = end;
+    return true;
+}
+
+// Lê a próxima linha a partir da posição atual, sem olhar o fim do trecho
+static ssize_t next_line(FileReader *reader, char **line) {
+    size_t line_length = 0;
+    bool carrying = false;
+
+    for (;;) {
+        ReadSlot *slot = &reader->slots[reader->current];
+        if (!reader->current_ready) {
+            if (!slot->submitted) break;  // Fim do arquivo
+            if (!wait_slot(reader, slot)) {
+                reader->failed = true;
+                return -1;
+            }
+            reader->current_ready = true;
+            reader->position = reader->start_skip;
+            reader->start_skip = 0;
+            if (reader->position > slot->length) reader->position = slot->length;
+        }
+
+        char *start = slot->data + reader->position;
+        size_t available = slot->length - reader->position;
+        char *newline = available > 0 ? memchr(start, '\n', available) : NULL;
+
+        if (newline) {
+            size_t length = (size_t)(newline - start);
+            reader->position += length + 1;
+            reader->line_offset = slot->offset + (off_t)reader->position;
+            if (!carrying) {
+                // Caso comum: a linha inteira está no bloco, sem cópia
+                *newline = '\0';
+                *line = start;
+                return (ssize_t)length;
+            }
+            if (!ensure_line_capacity(reader, line_length + length + 1)) {
+                reader->failed = true;
+                return -1;
+            }
+            memcpy(reader->line + line_length, start, length);
+            line_length += length;
+            reader->line[line_length] = '\0';
+            *line = reader->line;
+            return (ssize_t)line_length;
+        }
+
+        // A linha continua no próximo bloco: guarda o pedaço e recicla o slot
+        if (available > 0) {
+            if (!ensure_line_capacity(reader, line_length + available + 1)) {
+                reader->failed = true;
+                return -1;
+            }
+            memcpy(reader->line + line_length, start, available);
+            line_length += available;
+            carrying = true;
+        }
+        submit_slot(reader, reader->current);
+        reader->current = (reader->current + 1) % reader->slot_count;
+        reader->current_ready = false;
+    }
+
+    // Última linha sem quebra de linha no final
+    reader->line_offset = reader->file_size;
+    if (carrying) {
+        reader->line[line_length] = '\0';
+        *line = reader->line;
+        return (ssize_t)line_length;
+    }
+    return -1;
+}
+
+ssize_t file_reader_getline(FileReader *reader, char **line) {
+    if (!reader || !line) return -1;
+
+    if (reader->discard_partial) {
+        char *partial;
+        reader->discard_partial = false;
+        if (next_line(reader, &partial) < 0) return -1;
+    }
+    if (reader->line_offset >= reader->range_end) return -1;
+    return next_line(reader, line);
+}
+
+bool file_reader_failed(const FileReader *reader) {
+    return reader && reader->failed;
+}
+
+off_t file_reader_tell(const FileReader *reader) {
+    return reader ? reader->line_offset : 0;
+}
+
+void file_reader_close(FileReader *reader) {
+    if (!reader) return;
+
+#ifdef HAVE_LIBURING
+    if (reader->use_uring) {
+        drain_ring(reader);
+        io_uring_queue_exit(&reader->ring);
+    }
+#endif
+
+    if (reader->slots) {
+        for (int i = 0; i < reader->slot_count; i++) {
+            free(reader->slots[i].data);
+        }
+        free(reader->slots);
+    }
+    if (reader->fd >= 0) close(reader->fd);
+    free(reader->line);
+    free(reader);
+}
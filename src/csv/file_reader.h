@@ -0,0 +1,54 @@
+#ifndef FILE_READER_H
+#define FILE_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Backend de leitura dos arquivos CSV
+typedef enum {
+    READER_BACKEND_AUTO,     // io_uring quando disponível, senão pread
+    READER_BACKEND_URING,    // io_uring com várias leituras em voo
+    READER_BACKEND_PREAD     // pread síncrono com posix_fadvise
+} ReaderBackend;
+
+typedef struct {
+    ReaderBackend backend;
+    bool direct_io;       // Abre com O_DIRECT (não polui o page cache)
+    int queue_depth;      // Quantidade de leituras em voo por arquivo
+    size_t block_size;    // Tamanho de cada leitura (múltiplo de 4 KB)
+} FileReaderConfig;
+
+typedef struct FileReader FileReader;
+
+// Converte o nome do backend ("auto", "io_uring", "pread")
+ReaderBackend file_reader_parse_backend(const char *name);
+
+// Abre o arquivo e já dispara as primeiras leituras
+FileReader* file_reader_open(const char *path, const FileReaderConfig *config);
+
+// Abre o arquivo para ler só as linhas que começam em [start, end); a última
+// linha do trecho é lida até a quebra mesmo que passe de `end`. end < 0 = até o fim.
+FileReader* file_reader_open_range(const char *path, const FileReaderConfig *config, off_t start, off_t end);
+
+// Passa a ler as linhas que começam em [start, end). Um trecho que continua
+// o anterior não descarta os blocos já lidos.
+bool file_reader_set_range(FileReader *reader, off_t start, off_t end);
+
+// Retorna a próxima linha, sem a quebra de linha e terminada em '\0'.
+// O ponteiro é válido até a próxima chamada. Retorna -1 no fim do arquivo.
+ssize_t file_reader_getline(FileReader *reader, char **line);
+
+// Indica se a leitura parou por erro (e não pelo fim do trecho)
+bool file_reader_failed(const FileReader *reader);
+
+// Offset no arquivo do início da próxima linha a ser lida
+off_t file_reader_tell(const FileReader *reader);
+
+// Descreve o backend efetivamente usado (para o log)
+const char* file_reader_backend_name(const FileReader *reader);
+
+// Fecha o arquivo e libera os buffers
+void file_reader_close(FileReader *reader);
+
+#endif // FILE_READER_H
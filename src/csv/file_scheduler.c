@@ -0,0 +1,153 @@
+#include "file_scheduler.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Maior arquivo primeiro; mesmo tamanho, ordem do nome
+static int compare_jobs(const void *a, const void *b) {
+    const FileJob *left = (const FileJob*)a;
+    const FileJob *right = (const FileJob*)b;
+    if (left->size != right->size) return left->size > right->size ? -1 : 1;
+    return strcmp(left->filename, right->filename);
+}
+
+FileScheduler* file_scheduler_new(const char *dir, bool (*accept)(const char *filename), off_t chunk_size) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        logger_log(LOG_ERROR, "Erro ao abrir diretório %s", dir);
+        return NULL;
+    }
+
+    FileScheduler *scheduler = calloc(1, sizeof(FileScheduler));
+    if (!scheduler) {
+        closedir(handle);
+        return NULL;
+    }
+    scheduler->chunk_size = chunk_size > 0 ? chunk_size : 0;
+    pthread_mutex_init(&scheduler->mutex, NULL);
+    pthread_cond_init(&scheduler->published_cond, NULL);
+
+    int capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (accept && !accept(entry->d_name)) continue;
+
+        char path[512];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            logger_log(LOG_WARNING, "Arquivo %s ignorado: não foi possível obter o tamanho", path);
+            continue;
+        }
+
+        if (scheduler->job_count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            FileJob *jobs = realloc(scheduler->jobs, (size_t)capacity * sizeof(FileJob));
+            if (!jobs) break;
+            scheduler->jobs = jobs;
+        }
+        FileJob *job = &scheduler->jobs[scheduler->job_count];
+        memset(job, 0, sizeof(FileJob));
+        job->filename = strdup(entry->d_name);
+        if (!job->filename) break;
+        job->size = st.st_size;
+        scheduler->job_count++;
+    }
+    closedir(handle);
+
+    qsort(scheduler->jobs, (size_t)scheduler->job_count, sizeof(FileJob), compare_jobs);
+    return scheduler;
+}
+
+FileJob* file_scheduler_next(FileScheduler *scheduler) {
+    // Entrega e contagem juntas: quem não recebe arquivo já vê o último como pendente
+    FileJob *job = NULL;
+    pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->next_job < scheduler->job_count) {
+        job = &scheduler->jobs[scheduler->next_job++];
+        scheduler->unpublished++;
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+    return job;
+}
+
+void file_job_publish(FileScheduler *scheduler, FileJob *job, ColumnPlan *plan, off_t data_start, bool stealable) {
+    pthread_mutex_lock(&scheduler->mutex);
+    job->plan = plan;
+    job->data_start = data_start;
+    job->stealable = stealable && scheduler->chunk_size > 0;
+    __atomic_store_n(&job->next_chunk, data_start, __ATOMIC_RELAXED);
+    job->published = true;
+    scheduler->unpublished--;
+    pthread_cond_broadcast(&scheduler->published_cond);
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+void file_job_abandon(FileScheduler *scheduler, FileJob *job) {
+    pthread_mutex_lock(&scheduler->mutex);
+    if (!job->published) {
+        job->stealable = false;
+        job->published = true;
+        scheduler->unpublished--;
+        pthread_cond_broadcast(&scheduler->published_cond);
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+}
+
+bool file_job_claim(FileScheduler *scheduler, FileJob *job, off_t *start, off_t *end) {
+    off_t step = job->stealable ? scheduler->chunk_size : job->size;
+    off_t claimed = __atomic_fetch_add(&job->next_chunk, step, __ATOMIC_RELAXED);
+    if (claimed >= job->size) return false;
+
+    *start = claimed;
+    *end = claimed + step < job->size ? claimed + step : job->size;
+    return true;
+}
+
+FileJob* file_scheduler_steal(FileScheduler *scheduler, double *waited_seconds) {
+    if (scheduler->chunk_size == 0) return NULL;
+
+    FileJob *best = NULL;
+    pthread_mutex_lock(&scheduler->mutex);
+    for (;;) {
+        off_t best_remaining = 0;
+        for (int i = 0; i < scheduler->job_count; i++) {
+            FileJob *job = &scheduler->jobs[i];
+            if (!job->published || !job->stealable) continue;
+
+            off_t remaining = job->size - __atomic_load_n(&job->next_chunk, __ATOMIC_RELAXED);
+            if (remaining > best_remaining) {
+                best = job;
+                best_remaining = remaining;
+            }
+        }
+        // Um dono ainda lendo o cabeçalho pode publicar o arquivo a qualquer momento
+        if (best || scheduler->unpublished == 0) break;
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        pthread_cond_wait(&scheduler->published_cond, &scheduler->mutex);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        if (waited_seconds) {
+            *waited_seconds += (double)(after.tv_sec - before.tv_sec) + (double)(after.tv_nsec - before.tv_nsec) / 1e9;
+        }
+    }
+    pthread_mutex_unlock(&scheduler->mutex);
+    return best;
+}
+
+void file_scheduler_free(FileScheduler *scheduler) {
+    if (!scheduler) return;
+
+    for (int i = 0; i < scheduler->job_count; i++) {
+        free(scheduler->jobs[i].filename);
+        column_plan_free(scheduler->jobs[i].plan);
+    }
+    free(scheduler->jobs);
+    pthread_mutex_destroy(&scheduler->mutex);
+    pthread_cond_destroy(&scheduler->published_cond);
+    free(scheduler);
+}
@@ -0,0 +1,60 @@
+#ifndef FILE_SCHEDULER_H
+#define FILE_SCHEDULER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "../data/field_mapping.h"
+
+// Arquivo a importar. O dono (o worker que o recebeu de file_scheduler_next)
+// lê o cabeçalho e publica o plano de colunas; a partir daí o restante do
+// arquivo é distribuído em trechos, pedidos pelo dono e pelos workers ociosos.
+typedef struct {
+    char *filename;
+    off_t size;
+    off_t data_start;       // Início da primeira linha de dados, após o cabeçalho
+    off_t next_chunk;       // Próximo offset a distribuir (atômico)
+    ColumnPlan *plan;       // Plano do cabeçalho; pertence ao escalonador após publicado
+    bool stealable;         // Trechos podem ser roubados por outros workers
+    bool published;         // Plano publicado, ou o dono desistiu do arquivo
+} FileJob;
+
+typedef struct {
+    FileJob *jobs;          // Do maior para o menor arquivo
+    int job_count;
+    int next_job;           // Próximo arquivo a entregar
+    int unpublished;        // Arquivos entregues cujo dono ainda não publicou o plano
+    off_t chunk_size;       // Tamanho dos trechos roubáveis; 0 = sem roubo
+    pthread_mutex_t mutex;
+    pthread_cond_t published_cond;
+} FileScheduler;
+
+// Lista os arquivos de `dir` aceitos por `accept`, com o tamanho de cada um,
+// ordenados do maior para o menor (empate pelo nome)
+FileScheduler* file_scheduler_new(const char *dir, bool (*accept)(const char *filename), off_t chunk_size);
+
+// Entrega o próximo arquivo ainda sem dono; NULL quando todos foram entregues
+FileJob* file_scheduler_next(FileScheduler *scheduler);
+
+// Publicado pelo dono após o cabeçalho: libera os trechos a partir de `data_start`.
+// Com stealable = false (ou sem roubo), o dono recebe o arquivo inteiro de uma vez.
+void file_job_publish(FileScheduler *scheduler, FileJob *job, ColumnPlan *plan, off_t data_start, bool stealable);
+
+// O dono desistiu do arquivo antes de publicar (erro de abertura, arquivo vazio,
+// cabeçalho rejeitado, arquivo inalterado): libera quem espera para roubar.
+// Não faz nada se o plano já foi publicado.
+void file_job_abandon(FileScheduler *scheduler, FileJob *job);
+
+// Reserva o próximo trecho [start, end) do arquivo; false se não restou nada
+bool file_job_claim(FileScheduler *scheduler, FileJob *job, off_t *start, off_t *end);
+
+// Escolhe, entre os arquivos publicados e roubáveis, o que tem mais bytes
+// ainda não distribuídos. Enquanto algum arquivo entregue ainda não foi
+// publicado, espera por ele e soma o tempo de espera em `waited_seconds`
+// (pode ser NULL); NULL quando não há mais o que roubar.
+FileJob* file_scheduler_steal(FileScheduler *scheduler, double *waited_seconds);
+
+// Libera a lista e os planos publicados
+void file_scheduler_free(FileScheduler *scheduler);
+
+#endif // FILE_SCHEDULER_H
@@ -0,0 +1,330 @@
+#define _GNU_SOURCE
+#include "stream_reader.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define DEFAULT_BUFFER_SIZE (8 * 1024 * 1024)
+#define PIPE_BUFFER_SIZE (1024 * 1024)
+
+struct ChunkQueue {
+    StreamChunk **items;   // Anel de blocos prontos
+    int capacity;
+    int head;
+    int count;
+    int producers;         // Leitores ainda ativos
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+struct StreamReader {
+    char *path;
+    int stream_index;
+    size_t buffer_size;
+    ChunkQueue *queue;
+    pthread_t thread;
+    bool started;
+    volatile bool cancelled;
+    bool failed;
+
+    // Cabeçalho publicado pela thread de leitura
+    char *header;
+    bool header_ready;
+    pthread_mutex_t header_mutex;
+    pthread_cond_t header_cond;
+};
+
+ChunkQueue* chunk_queue_new(int capacity, int producers) {
+    if (capacity <= 0) capacity = 1;
+
+    ChunkQueue *queue = calloc(1, sizeof(ChunkQueue));
+    if (!queue) return NULL;
+    queue->items = calloc((size_t)capacity, sizeof(StreamChunk*));
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->capacity = capacity;
+    queue->producers = producers;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    return queue;
+}
+
+// Publica um bloco; bloqueia enquanto a fila estiver cheia
+static void chunk_queue_push(ChunkQueue *queue, StreamChunk *chunk) {
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->capacity) {
+        pthread_cond_wait(&queue->not_full, &queue->mutex);
+    }
+    queue->items[(queue->head + queue->count) % queue->capacity] = chunk;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void chunk_queue_producer_done(ChunkQueue *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->producers--;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+StreamChunk* chunk_queue_pop(ChunkQueue *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0 && queue->producers > 0) {
+        pthread_cond_wait(&queue->not_empty, &queue->mutex);
+    }
+    StreamChunk *chunk = NULL;
+    if (queue->count > 0) {
+        chunk = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return chunk;
+}
+
+void chunk_queue_free(ChunkQueue *queue) {
+    if (!queue) return;
+    while (queue->count > 0) {
+        stream_chunk_free(queue->items[queue->head]);
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+    }
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->items);
+    free(queue);
+}
+
+void stream_chunk_free(StreamChunk *chunk) {
+    if (!chunk) return;
+    free(chunk->data);
+    free(chunk);
+}
+
+StreamReader* stream_reader_new(const char *path, int stream_index, size_t buffer_size) {
+    if (!path) return NULL;
+
+    StreamReader *reader = calloc(1, sizeof(StreamReader));
+    if (!reader) return NULL;
+    reader->path = strdup(path);
+    if (!reader->path) {
+        free(reader);
+        return NULL;
+    }
+    reader->stream_index = stream_index;
+    reader->buffer_size = buffer_size > 0 ? buffer_size : DEFAULT_BUFFER_SIZE;
+    pthread_mutex_init(&reader->header_mutex, NULL);
+    pthread_cond_init(&reader->header_cond, NULL);
+    return reader;
+}
+
+static void publish_header(StreamReader *reader, char *header) {
+    pthread_mutex_lock(&reader->header_mutex);
+    reader->header = header;
+    reader->header_ready = true;
+    pthread_cond_broadcast(&reader->header_cond);
+    pthread_mutex_unlock(&reader->header_mutex);
+}
+
+// Lê até encher o buffer ou chegar ao fim do fluxo.
+// Retorna o total de bytes no buffer, ou -1 em erro de leitura.
+static ssize_t fill_buffer(int fd, char *buffer, size_t used, size_t capacity, bool *eof) {
+    while (used < capacity) {
+        ssize_t n = read(fd, buffer + used, capacity - used);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            *eof = true;
+            break;
+        }
+        used += (size_t)n;
+    }
+    return (ssize_t)used;
+}
+
+// Publica as linhas completas do buffer e devolve o buffer com a linha
+// incompleta do final, que segue para o próximo bloco
+static char* publish_chunk(StreamReader *reader, char *buffer, size_t length, size_t tail,
+                           size_t capacity, long *sequence) {
+    char *next = malloc(capacity + 1);
+    StreamChunk *chunk = malloc(sizeof(StreamChunk));
+    if (!next || !chunk) {
+        free(next);
+        free(chunk);
+        free(buffer);
+        return NULL;
+    }
+    memcpy(next, buffer + length, tail);
+
+    chunk->data = buffer;
+    chunk->length = length;
+    chunk->stream_index = reader->stream_index;
+    chunk->sequence = (*sequence)++;
+    chunk_queue_push(reader->queue, chunk);
+    return next;
+}
+
+// Thread de leitura: separa o cabeçalho e divide o fluxo em blocos de linhas completas
+static void* reader_thread(void *arg) {
+    StreamReader *reader = (StreamReader*)arg;
+    bool from_stdin = strcmp(reader->path, "-") == 0;
+    int fd = from_stdin ? STDIN_FILENO : open(reader->path, O_RDONLY);
+    if (fd < 0) {
+        logger_log(LOG_ERROR, "Erro ao abrir fluxo %s: %s", reader->path, strerror(errno));
+        reader->failed = true;
+        publish_header(reader, NULL);
+        chunk_queue_producer_done(reader->queue);
+        return NULL;
+    }
+
+#ifdef F_SETPIPE_SZ
+    // Pipes começam com 64 KB: um buffer maior reduz as trocas de contexto com o produtor
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        fcntl(fd, F_SETPIPE_SZ, PIPE_BUFFER_SIZE);
+    }
+#endif
+
+    // Um byte extra permite ao consumidor terminar a última linha com '\0'
+    size_t capacity = reader->buffer_size;
+    char *buffer = malloc(capacity + 1);
+    size_t used = 0;
+    bool eof = false;
+    bool have_header = false;
+    long sequence = 0;
+
+    while (buffer && !reader->cancelled) {
+        ssize_t filled = fill_buffer(fd, buffer, used, capacity, &eof);
+        if (filled < 0) {
+            logger_log(LOG_ERROR, "Erro ao ler fluxo %s: %s", reader->path, strerror(errno));
+            reader->failed = true;
+            break;
+        }
+        used = (size_t)filled;
+
+        size_t start = 0;
+        if (!have_header) {
+            char *newline = memchr(buffer, '\n', used);
+            if (!newline && !eof) {
+                // Cabeçalho maior que o buffer: amplia e continua lendo
+                char *grown = realloc(buffer, capacity * 2 + 1);
+                if (!grown) {
+                    free(buffer);
+                    buffer = NULL;
+                    break;
+                }
+                buffer = grown;
+                capacity *= 2;
+                continue;
+            }
+            size_t header_length = newline ? (size_t)(newline - buffer) : used;
+            publish_header(reader, used > 0 ? strndup(buffer, header_length) : NULL);
+            have_header = true;
+            start = newline ? header_length + 1 : used;
+            used -= start;
+            memmove(buffer, buffer + start, used);
+        }
+
+        if (eof) {
+            // A última linha pode não terminar com quebra de linha
+            if (used > 0) {
+                buffer = publish_chunk(reader, buffer, used, 0, capacity, &sequence);
+            }
+            break;
+        }
+
+        char *last_newline = memrchr(buffer, '\n', used);
+        if (!last_newline) {
+            // Linha maior que o buffer: amplia e continua lendo
+            char *grown = realloc(buffer, capacity * 2 + 1);
+            if (!grown) {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+            continue;
+        }
+        size_t length = (size_t)(last_newline - buffer) + 1;
+        size_t tail = used - length;
+        buffer = publish_chunk(reader, buffer, length, tail, capacity, &sequence);
+        used = tail;
+    }
+
+    if (!buffer && !reader->cancelled) {
+        logger_log(LOG_ERROR, "Memória insuficiente para o buffer do fluxo %s", reader->path);
+        reader->failed = true;
+    }
+    free(buffer);
+    if (!have_header) publish_header(reader, NULL);
+    if (!from_stdin) close(fd);
+    chunk_queue_producer_done(reader->queue);
+    return NULL;
+}
+
+bool stream_reader_start(StreamReader *reader, ChunkQueue *queue) {
+    if (!reader || !queue || reader->started) return false;
+    reader->queue = queue;
+    if (pthread_create(&reader->thread, NULL, reader_thread, reader) != 0) {
+        logger_log(LOG_ERROR, "Erro ao criar thread de leitura do fluxo %s", reader->path);
+        return false;
+    }
+    reader->started = true;
+    return true;
+}
+
+const char* stream_reader_header(StreamReader *reader) {
+    if (!reader) return NULL;
+    pthread_mutex_lock(&reader->header_mutex);
+    if (!reader->started && !reader->header_ready) {
+        pthread_mutex_unlock(&reader->header_mutex);
+        return NULL;
+    }
+    while (!reader->header_ready) {
+        pthread_cond_wait(&reader->header_cond, &reader->header_mutex);
+    }
+    pthread_mutex_unlock(&reader->header_mutex);
+    return reader->header;
+}
+
+void stream_reader_cancel(StreamReader *reader) {
+    if (reader) reader->cancelled = true;
+}
+
+const char* stream_reader_name(const StreamReader *reader) {
+    if (!reader) return "";
+    return strcmp(reader->path, "-") == 0 ? "stdin" : reader->path;
+}
+
+bool stream_reader_finish(StreamReader *reader) {
+    if (!reader || !reader->started) return false;
+    pthread_join(reader->thread, NULL);
+    reader->started = false;
+    return !reader->failed;
+}
+
+void stream_reader_free(StreamReader *reader) {
+    if (!reader) return;
+    if (reader->started) stream_reader_finish(reader);
+    pthread_mutex_destroy(&reader->header_mutex);
+    pthread_cond_destroy(&reader->header_cond);
+    free(reader->header);
+    free(reader->path);
+    free(reader);
+}
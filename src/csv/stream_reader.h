@@ -0,0 +1,58 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bloco de linhas completas lido de um fluxo: nenhuma linha fica partida
+// entre dois blocos. O bloco pertence a quem o retirou da fila.
+typedef struct {
+    char *data;
+    size_t length;
+    int stream_index;   // Fluxo de origem (posição em stream_reader_open)
+    long sequence;      // Ordem do bloco dentro do fluxo, a partir de 0
+} StreamChunk;
+
+// Fila limitada de blocos compartilhada entre leitores e workers
+typedef struct ChunkQueue ChunkQueue;
+
+typedef struct StreamReader StreamReader;
+
+// Cria a fila com capacidade para `capacity` blocos e `producers` leitores
+ChunkQueue* chunk_queue_new(int capacity, int producers);
+
+// Retira o próximo bloco; bloqueia até haver um. Retorna NULL quando
+// todos os leitores terminaram e a fila esvaziou.
+StreamChunk* chunk_queue_pop(ChunkQueue *queue);
+
+// Um leitor terminou: quando for o último, os workers são liberados
+void chunk_queue_producer_done(ChunkQueue *queue);
+
+void chunk_queue_free(ChunkQueue *queue);
+
+void stream_chunk_free(StreamChunk *chunk);
+
+// Prepara a leitura de um fluxo ("-" é a entrada padrão; outro caminho
+// pode ser um pipe nomeado). A abertura acontece na thread de leitura,
+// para que um pipe sem escritor não bloqueie os demais.
+StreamReader* stream_reader_new(const char *path, int stream_index, size_t buffer_size);
+
+// Inicia a thread de leitura, que publica os blocos em `queue`
+bool stream_reader_start(StreamReader *reader, ChunkQueue *queue);
+
+// Aguarda e retorna o cabeçalho (primeira linha, sem a quebra de linha).
+// Retorna NULL se o fluxo não pôde ser aberto ou está vazio.
+const char* stream_reader_header(StreamReader *reader);
+
+// Interrompe a leitura (ex.: cabeçalho rejeitado); os próximos blocos são descartados
+void stream_reader_cancel(StreamReader *reader);
+
+// Nome do fluxo para o log ("stdin" ou o caminho)
+const char* stream_reader_name(const StreamReader *reader);
+
+// Aguarda o fim da thread de leitura; retorna false se houve erro de leitura
+bool stream_reader_finish(StreamReader *reader);
+
+void stream_reader_free(StreamReader *reader);
+
+#endif // STREAM_READER_H
@@ -0,0 +1,295 @@
+#include "field_mapping.h"
+#include "../utils/logger.h"
+#include "../utils/string_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <json-c/json.h>
+
+// Nomes de colunas conhecidos, sem repetição, para montar a tabela hash
+typedef struct {
+    const char **names;
+    int count;
+} NameSet;
+
+static int name_set_add(NameSet *set, const char *name) {
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->names[i], name) == 0) return i;
+    }
+    const char **names = realloc(set->names, (set->count + 1) * sizeof(char*));
+    if (!names) return -1;
+    set->names = names;
+    set->names[set->count] = name;
+    return set->count++;
+}
+
+// Lê uma entrada do mapeamento: número = posição 1-based, string = nome da coluna
+static bool parse_column(struct json_object *value, const char *name, MappedColumn *column) {
+    column->name = name ? strdup(name) : NULL;
+    column->column_name = NULL;
+    column->position = -1;
+    column->key = -1;
+
+    if (json_object_is_type(value, json_type_string)) {
+        column->column_name = strdup(json_object_get_string(value));
+        return column->column_name != NULL;
+    }
+    if (json_object_is_type(value, json_type_int)) {
+        column->position = json_object_get_int(value) - 1;  // Ajusta para índice 0-based
+        return column->position >= 0;
+    }
+    return false;
+}
+
+static bool parse_column_array(struct json_object *array, MappedColumn **columns, int *count) {
+    int length = json_object_array_length(array);
+    *columns = calloc(length > 0 ? length : 1, sizeof(MappedColumn));
+    if (!*columns) return false;
+
+    for (int i = 0; i < length; i++) {
+        if (!parse_column(json_object_array_get_idx(array, i), NULL, &(*columns)[i])) {
+            *count = i + 1;
+            return false;
+        }
+    }
+    *count = length;
+    return true;
+}
+
+static void free_columns(MappedColumn *columns, int count) {
+    if (!columns) return;
+    for (int i = 0; i < count; i++) {
+        free(columns[i].name);
+        free(columns[i].column_name);
+    }
+    free(columns);
+}
+
+static bool register_columns(NameSet *set, MappedColumn *columns, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!columns[i].column_name) continue;
+        columns[i].key = name_set_add(set, columns[i].column_name);
+        if (columns[i].key < 0) return false;
+    }
+    return true;
+}
+
+FieldMapping* field_mapping_load(const char *mapping_file, char **whitelist, int whitelist_count) {
+    struct json_object *json = json_object_from_file(mapping_file);
+    if (!json) {
+        logger_log(LOG_ERROR, "Erro ao carregar mapeamento de campos: %s", mapping_file);
+        return NULL;
+    }
+
+    FieldMapping *mapping = calloc(1, sizeof(FieldMapping));
+    if (!mapping) {
+        json_object_put(json);
+        return NULL;
+    }
+
+    struct json_object *fields_obj, *contatos_obj, *telefones_obj, *emails_obj;
+    if (!json_object_object_get_ex(json, "fields", &fields_obj) ||
+        !json_object_object_get_ex(json, "contatos", &contatos_obj) ||
+        !json_object_object_get_ex(contatos_obj, "telefones", &telefones_obj) ||
+        !json_object_object_get_ex(contatos_obj, "emails", &emails_obj)) {
+        logger_log(LOG_ERROR, "Mapeamento incompleto: são necessários fields, contatos.telefones e contatos.emails");
+        json_object_put(json);
+        field_mapping_free(mapping);
+        return NULL;
+    }
+
+    // Campos básicos, na ordem do arquivo de mapeamento
+    bool ok = true;
+    struct json_object_iterator it = json_object_iter_begin(fields_obj);
+    struct json_object_iterator itEnd = json_object_iter_end(fields_obj);
+    while (ok && !json_object_iter_equal(&it, &itEnd)) {
+        MappedColumn *grown = realloc(mapping->fields, (mapping->field_count + 1) * sizeof(MappedColumn));
+        if (!grown) {
+            ok = false;
+            break;
+        }
+        mapping->fields = grown;
+        const char *field_name = json_object_iter_peek_name(&it);
+        ok = parse_column(json_object_iter_peek_value(&it), field_name, &mapping->fields[mapping->field_count]);
+        mapping->field_count++;
+        if (!ok) logger_log(LOG_ERROR, "Coluna inválida no mapeamento do campo %s", field_name);
+        json_object_iter_next(&it);
+    }
+
+    if (ok && !parse_column_array(telefones_obj, &mapping->telefones, &mapping->telefone_count)) {
+        logger_log(LOG_ERROR, "Coluna inválida no mapeamento de telefones");
+        ok = false;
+    }
+    if (ok && !parse_column_array(emails_obj, &mapping->emails, &mapping->email_count)) {
+        logger_log(LOG_ERROR, "Coluna inválida no mapeamento de emails");
+        ok = false;
+    }
+    json_object_put(json);
+
+    // Tabela hash perfeita com os nomes do mapeamento e da whitelist
+    NameSet names = {0};
+    if (ok) {
+        ok = register_columns(&names, mapping->fields, mapping->field_count) &&
+             register_columns(&names, mapping->telefones, mapping->telefone_count) &&
+             register_columns(&names, mapping->emails, mapping->email_count);
+        for (int i = 0; ok && whitelist && i < whitelist_count; i++) {
+            ok = name_set_add(&names, whitelist[i]) >= 0;
+        }
+    }
+    if (ok) {
+        mapping->header_hash = perfect_hash_build(names.names, names.count);
+        mapping->has_whitelist = whitelist && whitelist_count > 0;
+        ok = mapping->header_hash != NULL;
+    }
+    free(names.names);
+
+    if (!ok) {
+        field_mapping_free(mapping);
+        return NULL;
+    }
+
+    logger_log(LOG_INFO, "Mapeamento compilado: %d campos, %d telefones, %d emails, %d colunas conhecidas",
+        mapping->field_count, mapping->telefone_count, mapping->email_count, mapping->header_hash->key_count);
+    return mapping;
+}
+
+void field_mapping_free(FieldMapping *mapping) {
+    if (!mapping) return;
+    free_columns(mapping->fields, mapping->field_count);
+    free_columns(mapping->telefones, mapping->telefone_count);
+    free_columns(mapping->emails, mapping->email_count);
+    perfect_hash_free(mapping->header_hash);
+    free(mapping);
+}
+
+// Remove espaços, quebras de linha e aspas ao redor do nome da coluna
+static const char* trim_column_name(const char *name, size_t *length) {
+    const char *start = name;
+    const char *end = name + strlen(name);
+    while (start < end && (*start == ' ' || *start == '\t' || *start == '"')) start++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '"' ||
+                           end[-1] == '\r' || end[-1] == '\n')) end--;
+    *length = (size_t)(end - start);
+    return start;
+}
+
+// Converte as entradas do mapeamento em índices de coluna do arquivo
+static bool plan_columns(const MappedColumn *columns, int count, const int *key_columns,
+                         int header_count, int *out, const char *filename) {
+    for (int i = 0; i < count; i++) {
+        if (columns[i].column_name) {
+            out[i] = key_columns[columns[i].key];
+            if (out[i] < 0) {
+                logger_log(LOG_ERROR, "Arquivo %s rejeitado: coluna '%s' ausente no cabeçalho",
+                    filename, columns[i].column_name);
+                return false;
+            }
+        } else {
+            out[i] = columns[i].position;
+            if (out[i] >= header_count) {
+                logger_log(LOG_ERROR, "Arquivo %s rejeitado: cabeçalho tem %d colunas, mapeamento usa a posição %d",
+                    filename, header_count, out[i] + 1);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void mark_columns(unsigned char *used, const int *columns, int count) {
+    for (int i = 0; i < count; i++) {
+        used[columns[i]] = 1;
+    }
+}
+
+ColumnPlan* field_mapping_resolve(const FieldMapping *mapping, const char *header_line, const char *filename) {
+    if (!mapping || !header_line) return NULL;
+
+    char **header = NULL;
+    int header_count = split_string(header_line, ";", &header);
+    if (header_count <= 0 || !header) {
+        logger_log(LOG_ERROR, "Arquivo %s rejeitado: cabeçalho inválido", filename);
+        return NULL;
+    }
+
+    ColumnPlan *plan = calloc(1, sizeof(ColumnPlan));
+    int key_count = mapping->header_hash->key_count;
+    int *key_columns = malloc((key_count > 0 ? key_count : 1) * sizeof(int));
+    if (!plan || !key_columns) {
+        free(plan);
+        free(key_columns);
+        free_string_array(header, header_count);
+        return NULL;
+    }
+    plan->header_count = header_count;
+    for (int i = 0; i < key_count; i++) key_columns[i] = -1;
+
+    // Cada coluna do cabeçalho é resolvida uma vez na tabela hash perfeita
+    bool ok = true;
+    for (int i = 0; ok && i < header_count; i++) {
+        size_t length;
+        const char *name = trim_column_name(header[i], &length);
+        int key = perfect_hash_lookup(mapping->header_hash, name, length);
+        if (key < 0) {
+            if (mapping->has_whitelist) {
+                logger_log(LOG_ERROR, "Arquivo %s rejeitado: coluna %d '%.*s' não consta em fields.txt",
+                    filename, i + 1, (int)length, name);
+                ok = false;
+            }
+            continue;
+        }
+        if (key_columns[key] >= 0) {
+            logger_log(LOG_ERROR, "Arquivo %s rejeitado: coluna '%.*s' repetida no cabeçalho",
+                filename, (int)length, name);
+            ok = false;
+            continue;
+        }
+        key_columns[key] = i;
+    }
+    free_string_array(header, header_count);
+
+    if (ok) {
+        plan->field_columns = malloc((mapping->field_count + 1) * sizeof(int));
+        plan->telefone_columns = malloc((mapping->telefone_count + 1) * sizeof(int));
+        plan->email_columns = malloc((mapping->email_count + 1) * sizeof(int));
+        ok = plan->field_columns && plan->telefone_columns && plan->email_columns &&
+             plan_columns(mapping->fields, mapping->field_count, key_columns, header_count, plan->field_columns, filename) &&
+             plan_columns(mapping->telefones, mapping->telefone_count, key_columns, header_count, plan->telefone_columns, filename) &&
+             plan_columns(mapping->emails, mapping->email_count, key_columns, header_count, plan->email_columns, filename);
+    }
+    free(key_columns);
+
+    // Conjunto de colunas que alguma entrada usa; as demais nem são tokenizadas
+    if (ok) {
+        unsigned char *used = calloc(header_count, 1);
+        plan->needed_columns = malloc(header_count * sizeof(int));
+        ok = used && plan->needed_columns;
+        if (ok) {
+            mark_columns(used, plan->field_columns, mapping->field_count);
+            mark_columns(used, plan->telefone_columns, mapping->telefone_count);
+            mark_columns(used, plan->email_columns, mapping->email_count);
+            plan->max_column = -1;
+            for (int i = 0; i < header_count; i++) {
+                if (!used[i]) continue;
+                plan->needed_columns[plan->needed_count++] = i;
+                plan->max_column = i;
+            }
+        }
+        free(used);
+    }
+
+    if (!ok) {
+        column_plan_free(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+void column_plan_free(ColumnPlan *plan) {
+    if (!plan) return;
+    free(plan->field_columns);
+    free(plan->telefone_columns);
+    free(plan->email_columns);
+    free(plan->needed_columns);
+    free(plan);
+}
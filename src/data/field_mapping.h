@@ -0,0 +1,52 @@
+#ifndef FIELD_MAPPING_H
+#define FIELD_MAPPING_H
+
+#include <stdbool.h>
+#include "../utils/perfect_hash.h"
+
+// Uma coluna referenciada pelo mapeamento. No field_mapping.json o valor pode
+// ser a posição 1-based (número) ou o nome da coluna no cabeçalho (string).
+typedef struct {
+    char *name;          // Nome do campo no documento (NULL para telefones/emails)
+    char *column_name;   // Nome da coluna no cabeçalho (NULL = posição fixa)
+    int position;        // Posição 0-based, usada quando column_name é NULL
+    int key;             // Índice de column_name na tabela hash do cabeçalho
+} MappedColumn;
+
+// Mapeamento compilado uma única vez na inicialização
+typedef struct {
+    MappedColumn *fields;
+    int field_count;
+    MappedColumn *telefones;
+    int telefone_count;
+    MappedColumn *emails;
+    int email_count;
+    PerfectHash *header_hash;  // Colunas conhecidas: mapeamento + fields.txt
+    bool has_whitelist;        // Rejeita colunas fora de fields.txt
+} FieldMapping;
+
+// Plano de colunas de um arquivo: índice 0-based de cada entrada do mapeamento
+typedef struct {
+    int *field_columns;
+    int *telefone_columns;
+    int *email_columns;
+    int header_count;
+    int *needed_columns;   // Colunas referenciadas, em ordem crescente e sem repetição
+    int needed_count;
+    int max_column;        // Última coluna referenciada: o tokenizer para nela
+} ColumnPlan;
+
+// Carrega e compila o mapeamento; whitelist pode ser NULL (sem validação)
+FieldMapping* field_mapping_load(const char *mapping_file, char **whitelist, int whitelist_count);
+
+// Libera o mapeamento compilado
+void field_mapping_free(FieldMapping *mapping);
+
+// Resolve o cabeçalho de um arquivo contra o mapeamento.
+// Retorna NULL (e registra o motivo no log) se o layout não for compatível.
+ColumnPlan* field_mapping_resolve(const FieldMapping *mapping, const char *header_line, const char *filename);
+
+// Libera o plano de colunas
+void column_plan_free(ColumnPlan *plan);
+
+#endif // FIELD_MAPPING_H
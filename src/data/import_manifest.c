@@ -0,0 +1,151 @@
+#include "import_manifest.h"
+#include "../utils/hash.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HASH_BUFFER_SIZE (1024 * 1024)
+
+struct ImportManifest {
+    char *path;
+    ManifestEntry *entries;
+    int count;
+    pthread_mutex_t mutex;
+};
+
+ImportManifest* manifest_load(const char *path) {
+    ImportManifest *manifest = calloc(1, sizeof(ImportManifest));
+    if (!manifest) return NULL;
+    manifest->path = strdup(path);
+    pthread_mutex_init(&manifest->mutex, NULL);
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        logger_log(LOG_INFO, "Manifesto %s não encontrado: todos os arquivos serão importados", path);
+        return manifest;
+    }
+
+    // Formato: nome<TAB>tamanho<TAB>mtime_ns<TAB>hash
+    char name[256];
+    long long size;
+    int64_t mtime_ns;
+    uint64_t hash;
+    while (fscanf(file, "%255[^\t]\t%lld\t%" SCNd64 "\t%" SCNx64 "\n", name, &size, &mtime_ns, &hash) == 4) {
+        manifest_update(manifest, name, (off_t)size, mtime_ns, hash);
+    }
+    fclose(file);
+
+    logger_log(LOG_INFO, "Manifesto %s carregado: %d arquivos", path, manifest->count);
+    return manifest;
+}
+
+static ManifestEntry* find_entry(ImportManifest *manifest, const char *filename) {
+    for (int i = 0; i < manifest->count; i++) {
+        if (strcmp(manifest->entries[i].filename, filename) == 0) return &manifest->entries[i];
+    }
+    return NULL;
+}
+
+bool manifest_find(ImportManifest *manifest, const char *filename, ManifestEntry *entry) {
+    if (!manifest || !filename) return false;
+    pthread_mutex_lock(&manifest->mutex);
+    ManifestEntry *found = find_entry(manifest, filename);
+    if (found && entry) *entry = *found;
+    pthread_mutex_unlock(&manifest->mutex);
+    return found != NULL;
+}
+
+bool manifest_update(ImportManifest *manifest, const char *filename, off_t size, int64_t mtime_ns, uint64_t content_hash) {
+    if (!manifest || !filename) return false;
+    bool ok = true;
+
+    pthread_mutex_lock(&manifest->mutex);
+    ManifestEntry *entry = find_entry(manifest, filename);
+    if (!entry) {
+        ManifestEntry *entries = realloc(manifest->entries, (manifest->count + 1) * sizeof(ManifestEntry));
+        char *name = strdup(filename);
+        if (!entries || !name) {
+            if (entries) manifest->entries = entries;
+            free(name);
+            ok = false;
+        } else {
+            manifest->entries = entries;
+            entry = &manifest->entries[manifest->count++];
+            entry->filename = name;
+        }
+    }
+    if (entry) {
+        entry->size = size;
+        entry->mtime_ns = mtime_ns;
+        entry->content_hash = content_hash;
+    }
+    pthread_mutex_unlock(&manifest->mutex);
+    return ok;
+}
+
+bool manifest_save(ImportManifest *manifest) {
+    if (!manifest) return false;
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", manifest->path);
+    FILE *file = fopen(tmp_path, "w");
+    if (!file) {
+        logger_log(LOG_ERROR, "Erro ao gravar manifesto: %s", tmp_path);
+        return false;
+    }
+
+    pthread_mutex_lock(&manifest->mutex);
+    for (int i = 0; i < manifest->count; i++) {
+        ManifestEntry *entry = &manifest->entries[i];
+        fprintf(file, "%s\t%lld\t%" PRId64 "\t%016" PRIx64 "\n",
+            entry->filename, (long long)entry->size, entry->mtime_ns, entry->content_hash);
+    }
+    pthread_mutex_unlock(&manifest->mutex);
+
+    bool ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    if (ok && rename(tmp_path, manifest->path) != 0) ok = false;
+    if (!ok) logger_log(LOG_ERROR, "Erro ao gravar manifesto: %s", manifest->path);
+    return ok;
+}
+
+void manifest_free(ImportManifest *manifest) {
+    if (!manifest) return;
+    for (int i = 0; i < manifest->count; i++) {
+        free(manifest->entries[i].filename);
+    }
+    free(manifest->entries);
+    free(manifest->path);
+    pthread_mutex_destroy(&manifest->mutex);
+    free(manifest);
+}
+
+bool file_content_hash(const char *path, uint64_t *hash) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    char *buffer = malloc(HASH_BUFFER_SIZE);
+    if (!buffer) {
+        close(fd);
+        return false;
+    }
+
+    // Encadeia o hash de cada bloco no hash do bloco seguinte
+    uint64_t h = 0;
+    ssize_t n;
+    while ((n = read(fd, buffer, HASH_BUFFER_SIZE)) > 0) {
+        h = hash_bytes(buffer, (size_t)n, h);
+    }
+
+    free(buffer);
+    close(fd);
+    if (n < 0) return false;
+    *hash = h;
+    return true;
+}
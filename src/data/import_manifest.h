@@ -0,0 +1,37 @@
+#ifndef IMPORT_MANIFEST_H
+#define IMPORT_MANIFEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Estado de um arquivo na última importação bem-sucedida
+typedef struct {
+    char *filename;
+    off_t size;
+    int64_t mtime_ns;
+    uint64_t content_hash;
+} ManifestEntry;
+
+// Manifesto da importação incremental (state_dir/manifest.tsv)
+typedef struct ImportManifest ImportManifest;
+
+// Carrega o manifesto; um arquivo inexistente resulta em manifesto vazio
+ImportManifest* manifest_load(const char *path);
+
+// Copia a entrada do arquivo em entry; retorna false se não existir
+bool manifest_find(ImportManifest *manifest, const char *filename, ManifestEntry *entry);
+
+// Cria ou atualiza a entrada de um arquivo (thread-safe)
+bool manifest_update(ImportManifest *manifest, const char *filename, off_t size, int64_t mtime_ns, uint64_t content_hash);
+
+// Grava o manifesto de forma atômica (arquivo temporário + rename)
+bool manifest_save(ImportManifest *manifest);
+
+// Libera o manifesto
+void manifest_free(ImportManifest *manifest);
+
+// Calcula o hash do conteúdo de um arquivo
+bool file_content_hash(const char *path, uint64_t *hash);
+
+#endif // IMPORT_MANIFEST_H
@@ -0,0 +1,68 @@
+#include "load_digest.h"
+
+int load_digest_range(const char *key, size_t key_length) {
+    if (key_length == 0 || key[0] < '0' || key[0] > '9') return DIGEST_OTHER_RANGE;
+    return key[0] - '0';
+}
+
+int64_t load_digest_key_value(const char *key, size_t key_length) {
+    int64_t value = 0;
+    for (size_t i = 0; i < key_length; i++) {
+        char c = key[i];
+        if (c == '.' || c == '-') continue;
+        if (c < '0' || c > '9') return 0;
+        // Como o $convert para long: 19 dígitos cabem até INT64_MAX; acima disso, erro
+        int digit = c - '0';
+        if (value > (INT64_MAX - digit) / 10) return 0;
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+// Conta caracteres (code points) como o $strLenCP: bytes de continuação não contam
+static int64_t utf8_length(const char *text, size_t length) {
+    int64_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (((unsigned char)text[i] & 0xC0) != 0x80) count++;
+    }
+    return count;
+}
+
+void load_digest_add(LoadDigest *digest, const char *key, size_t key_length,
+                     const char *text, size_t text_length) {
+    DigestRow row = load_digest_row(key, key_length, text, text_length);
+    load_digest_add_row(digest, &row);
+}
+
+DigestRow load_digest_row(const char *key, size_t key_length, const char *text, size_t text_length) {
+    DigestRow row = {
+        .range = load_digest_range(key, key_length),
+        .key_value = load_digest_key_value(key, key_length) % DIGEST_KEY_MODULUS,
+        .length = utf8_length(text, text_length)
+    };
+    return row;
+}
+
+void load_digest_add_row(LoadDigest *digest, const DigestRow *row) {
+    if (row->range < 0) return;
+    DigestRange *range = &digest->ranges[row->range];
+    range->count++;
+    range->key_sum += row->key_value;
+    range->length_sum += row->length;
+}
+
+void load_digest_remove_row(LoadDigest *digest, const DigestRow *row) {
+    if (row->range < 0) return;
+    DigestRange *range = &digest->ranges[row->range];
+    range->count--;
+    range->key_sum -= row->key_value;
+    range->length_sum -= row->length;
+}
+
+void load_digest_merge(LoadDigest *into, const LoadDigest *from) {
+    for (int i = 0; i < DIGEST_RANGE_COUNT; i++) {
+        into->ranges[i].count += from->ranges[i].count;
+        into->ranges[i].key_sum += from->ranges[i].key_sum;
+        into->ranges[i].length_sum += from->ranges[i].length_sum;
+    }
+}
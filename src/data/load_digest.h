@@ -0,0 +1,61 @@
+#ifndef LOAD_DIGEST_H
+#define LOAD_DIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Faixas de verificação pelo primeiro caractere da chave: '0' a '9' e uma
+// faixa para as demais chaves (vazias ou que não começam com dígito)
+#define DIGEST_RANGE_COUNT 11
+#define DIGEST_OTHER_RANGE 10
+
+// Módulo aplicado ao valor numérico da chave antes da soma, para que a soma
+// de milhões de linhas caiba em 64 bits no cliente e no servidor
+#define DIGEST_KEY_MODULUS 1000000007LL
+
+// Digest de uma faixa: independe da ordem das linhas e pode ser recalculado
+// no servidor com $sum
+typedef struct {
+    int64_t count;        // Documentos
+    int64_t key_sum;      // Soma de (valor numérico da chave % DIGEST_KEY_MODULUS)
+    int64_t length_sum;   // Soma do tamanho, em caracteres, do campo de texto
+} DigestRange;
+
+typedef struct {
+    DigestRange ranges[DIGEST_RANGE_COUNT];
+} LoadDigest;
+
+// Contribuição de um documento ao digest; range < 0 quando não conta
+typedef struct {
+    int range;
+    int64_t key_value;    // Já reduzido pelo módulo
+    int64_t length;
+} DigestRow;
+
+// Digest das linhas de um arquivo (ou fluxo), para apontar a origem de uma divergência
+typedef struct {
+    char *source;
+    LoadDigest digest;
+} SourceDigest;
+
+// Faixa da chave (índice em LoadDigest.ranges)
+int load_digest_range(const char *key, size_t key_length);
+
+// Valor numérico da chave ignorando '.' e '-'; 0 se houver outro caractere
+// não numérico ou se o valor não couber em int64 (como o $convert para long
+// com onError: 0)
+int64_t load_digest_key_value(const char *key, size_t key_length);
+
+// Acumula um documento gravado
+void load_digest_add(LoadDigest *digest, const char *key, size_t key_length,
+                     const char *text, size_t text_length);
+
+// Contribuição de um documento, para acumular agora e desfazer se a escrita falhar
+DigestRow load_digest_row(const char *key, size_t key_length, const char *text, size_t text_length);
+void load_digest_add_row(LoadDigest *digest, const DigestRow *row);
+void load_digest_remove_row(LoadDigest *digest, const DigestRow *row);
+
+// Soma o digest `from` em `into`
+void load_digest_merge(LoadDigest *into, const LoadDigest *from);
+
+#endif // LOAD_DIGEST_H
@@ -0,0 +1,83 @@
+#include "pending_rows.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct PendingRows {
+    PendingRow *rows;
+    int capacity;
+    int free_head;      // Primeira vaga livre (-1 = nenhuma)
+};
+
+PendingRows* pending_rows_new(void) {
+    PendingRows *rows = calloc(1, sizeof(PendingRows));
+    if (rows) rows->free_head = -1;
+    return rows;
+}
+
+// Dobra as vagas e encadeia as novas na lista de livres
+static bool grow(PendingRows *rows) {
+    int capacity = rows->capacity ? rows->capacity * 2 : 256;
+    PendingRow *grown = realloc(rows->rows, (size_t)capacity * sizeof(PendingRow));
+    if (!grown) return false;
+    memset(grown + rows->capacity, 0, (size_t)(capacity - rows->capacity) * sizeof(PendingRow));
+    for (int i = capacity - 1; i >= rows->capacity; i--) {
+        grown[i].next_free = rows->free_head;
+        rows->free_head = i;
+    }
+    rows->rows = grown;
+    rows->capacity = capacity;
+    return true;
+}
+
+int pending_rows_add(PendingRows *rows, const char *source, long line_number, const char *line,
+                     size_t length, int origin, const DigestRow *digest) {
+    if (!rows) return -1;
+    if (rows->free_head < 0 && !grow(rows)) return -1;
+
+    int tag = rows->free_head;
+    PendingRow *row = &rows->rows[tag];
+    if (length + 1 > row->capacity) {
+        size_t capacity = length + 1 > 256 ? length + 1 : 256;
+        char *buffer = realloc(row->line, capacity);
+        if (!buffer) return -1;
+        row->line = buffer;
+        row->capacity = capacity;
+    }
+    memcpy(row->line, line, length);
+    row->line[length] = '\0';
+    row->length = length;
+    snprintf(row->source, sizeof(row->source), "%s", source);
+    row->line_number = line_number;
+    row->origin = origin;
+    row->digest = *digest;
+    row->used = true;
+    rows->free_head = row->next_free;
+    return tag;
+}
+
+const PendingRow* pending_rows_get(const PendingRows *rows, int tag) {
+    return rows && tag >= 0 && tag < rows->capacity && rows->rows[tag].used ? &rows->rows[tag] : NULL;
+}
+
+int pending_rows_next(const PendingRows *rows, int after) {
+    if (!rows) return -1;
+    for (int i = after + 1; i < rows->capacity; i++) {
+        if (rows->rows[i].used) return i;
+    }
+    return -1;
+}
+
+void pending_rows_release(PendingRows *rows, int tag) {
+    if (!pending_rows_get(rows, tag)) return;
+    rows->rows[tag].used = false;
+    rows->rows[tag].next_free = rows->free_head;
+    rows->free_head = tag;
+}
+
+void pending_rows_free(PendingRows *rows) {
+    if (!rows) return;
+    for (int i = 0; i < rows->capacity; i++) free(rows->rows[i].line);
+    free(rows->rows);
+    free(rows);
+}
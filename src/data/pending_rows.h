@@ -0,0 +1,44 @@
+#ifndef PENDING_ROWS_H
+#define PENDING_ROWS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "load_digest.h"
+
+#define PENDING_SOURCE_SIZE 288
+
+// Linha original de um documento que está em um lote ainda não confirmado
+typedef struct {
+    char source[PENDING_SOURCE_SIZE];  // Origem na quarentena: arquivo, arquivo@offset ou fluxo#bloco
+    long line_number;
+    char *line;
+    size_t length;
+    size_t capacity;
+    int origin;          // Índice do arquivo ou fluxo no worker
+    DigestRow digest;    // Contribuição ao digest, desfeita se a escrita falhar
+    bool used;
+    int next_free;
+} PendingRow;
+
+// Linhas pendentes de um worker. Cada linha recebe um tag (o índice da
+// vaga), repassado ao lote junto com o documento; as vagas e seus buffers
+// são reaproveitados quando o lote é confirmado.
+typedef struct PendingRows PendingRows;
+
+PendingRows* pending_rows_new(void);
+
+// Guarda uma cópia da linha; retorna o tag, ou -1 sem memória
+int pending_rows_add(PendingRows *rows, const char *source, long line_number, const char *line,
+                     size_t length, int origin, const DigestRow *digest);
+
+const PendingRow* pending_rows_get(const PendingRows *rows, int tag);
+
+// Próximo tag em uso depois de `after` (-1 para o primeiro); -1 quando não há mais
+int pending_rows_next(const PendingRows *rows, int after);
+
+// Libera a vaga para uma próxima linha
+void pending_rows_release(PendingRows *rows, int tag);
+
+void pending_rows_free(PendingRows *rows);
+
+#endif // PENDING_ROWS_H
@@ -0,0 +1,136 @@
+#include "reject_writer.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define REJECT_BUFFER_SIZE (1024 * 1024)
+
+struct RejectWriter {
+    char path[512];
+    char dir[256];
+    int fd;             // -1 até a primeira rejeição
+    bool failed;        // Erro ao abrir ou gravar: as próximas linhas só são contadas
+    char *buffer;
+    size_t used;
+};
+
+// Contadores globais, atualizados sem lock pelos workers
+static long reject_totals[REJECT_REASON_COUNT];
+
+static const char *reason_codes[REJECT_REASON_COUNT] = {
+    "split", "sem_chave", "memoria", "escrita"
+};
+
+const char* reject_reason_code(RejectReason reason) {
+    return reason < REJECT_REASON_COUNT ? reason_codes[reason] : "desconhecido";
+}
+
+RejectWriter* reject_writer_new(const char *dir, const char *name) {
+    if (!dir || !name) return NULL;
+
+    RejectWriter *writer = calloc(1, sizeof(RejectWriter));
+    if (!writer) return NULL;
+    snprintf(writer->dir, sizeof(writer->dir), "%s", dir);
+    snprintf(writer->path, sizeof(writer->path), "%s/%s", dir, name);
+    writer->fd = -1;
+    return writer;
+}
+
+// Grava o buffer inteiro, repetindo em escritas parciais
+static bool flush_buffer(RejectWriter *writer) {
+    size_t done = 0;
+    while (done < writer->used) {
+        ssize_t n = write(writer->fd, writer->buffer + done, writer->used - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            logger_log(LOG_ERROR, "Erro ao gravar rejeições em %s: %s", writer->path, strerror(errno));
+            writer->failed = true;
+            return false;
+        }
+        done += (size_t)n;
+    }
+    writer->used = 0;
+    return true;
+}
+
+// Cria o diretório e o arquivo na primeira rejeição
+static bool open_file(RejectWriter *writer) {
+    if (mkdir(writer->dir, 0755) != 0 && errno != EEXIST) {
+        logger_log(LOG_ERROR, "Erro ao criar diretório de rejeições %s: %s", writer->dir, strerror(errno));
+        return false;
+    }
+    writer->buffer = malloc(REJECT_BUFFER_SIZE);
+    if (!writer->buffer) return false;
+    writer->fd = open(writer->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        logger_log(LOG_ERROR, "Erro ao criar arquivo de rejeições %s: %s", writer->path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Copia para o buffer, gravando sempre que ele enche
+static bool append(RejectWriter *writer, const char *data, size_t length) {
+    while (length > 0) {
+        if (writer->used == REJECT_BUFFER_SIZE && !flush_buffer(writer)) return false;
+        size_t room = REJECT_BUFFER_SIZE - writer->used;
+        size_t n = length < room ? length : room;
+        memcpy(writer->buffer + writer->used, data, n);
+        writer->used += n;
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+static bool is_power_of_ten(long value) {
+    while (value >= 10 && value % 10 == 0) value /= 10;
+    return value == 1;
+}
+
+bool reject_writer_add(RejectWriter *writer, const char *source, long line_number,
+                       RejectReason reason, const char *line, size_t length) {
+    if (reason >= REJECT_REASON_COUNT) return false;
+
+    long total = __atomic_add_fetch(&reject_totals[reason], 1, __ATOMIC_RELAXED);
+    if (is_power_of_ten(total)) {
+        logger_log(LOG_ERROR, "Linha rejeitada (%s): %s linha %ld; %ld rejeições deste motivo até agora",
+            reason_codes[reason], source, line_number, total);
+    }
+
+    if (!writer || writer->failed) return false;
+    if (writer->fd < 0 && !open_file(writer)) {
+        writer->failed = true;
+        return false;
+    }
+
+    char prefix[320];
+    int prefix_length = snprintf(prefix, sizeof(prefix), "%s\t%ld\t%s\t", source, line_number, reason_codes[reason]);
+    if (prefix_length < 0 || (size_t)prefix_length >= sizeof(prefix)) prefix_length = (int)sizeof(prefix) - 1;
+    return append(writer, prefix, (size_t)prefix_length) &&
+           append(writer, line, length) &&
+           append(writer, "\n", 1);
+}
+
+bool reject_writer_close(RejectWriter *writer) {
+    if (!writer) return true;
+
+    bool ok = !writer->failed;
+    if (writer->fd >= 0) {
+        if (ok) ok = flush_buffer(writer);
+        close(writer->fd);
+    }
+    free(writer->buffer);
+    free(writer);
+    return ok;
+}
+
+long reject_count(RejectReason reason) {
+    if (reason >= REJECT_REASON_COUNT) return 0;
+    return __atomic_load_n(&reject_totals[reason], __ATOMIC_RELAXED);
+}
@@ -0,0 +1,37 @@
+#ifndef REJECT_WRITER_H
+#define REJECT_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Motivos de rejeição de uma linha
+typedef enum {
+    REJECT_SPLIT,      // Linha não pôde ser dividida em campos
+    REJECT_NO_KEY,     // Sem chave no modo incremental
+    REJECT_MEMORY,     // Sem memória para converter a linha ou montar o BSON
+    REJECT_WRITE,      // Escrita recusada pelo MongoDB
+    REJECT_REASON_COUNT
+} RejectReason;
+
+// Quarentena de um worker: as linhas rejeitadas são acumuladas em um buffer
+// e gravadas em blocos grandes. O arquivo só é criado na primeira rejeição.
+typedef struct RejectWriter RejectWriter;
+
+// Código do motivo, gravado no arquivo de rejeições
+const char* reject_reason_code(RejectReason reason);
+
+// Prepara a quarentena em `dir`/`name`
+RejectWriter* reject_writer_new(const char *dir, const char *name);
+
+// Registra a linha original como "arquivo\tlinha\tmotivo\tconteúdo". O log
+// recebe só a 1ª, 10ª, 100ª... rejeição de cada motivo, com o total até ali.
+bool reject_writer_add(RejectWriter *writer, const char *source, long line_number,
+                       RejectReason reason, const char *line, size_t length);
+
+// Grava o que resta no buffer e fecha o arquivo; retorna false em erro de escrita
+bool reject_writer_close(RejectWriter *writer);
+
+// Total de linhas rejeitadas pelo motivo, somando todos os workers
+long reject_count(RejectReason reason);
+
+#endif // REJECT_WRITER_H
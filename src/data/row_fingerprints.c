@@ -0,0 +1,108 @@
+#include "row_fingerprints.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FINGERPRINT_MAGIC "CSVFP001"
+
+static int compare_rows(const void *a, const void *b) {
+    return strncmp(((const RowFingerprint*)a)->key, ((const RowFingerprint*)b)->key, FINGERPRINT_KEY_SIZE);
+}
+
+FingerprintSet* fingerprints_new() {
+    return calloc(1, sizeof(FingerprintSet));
+}
+
+FingerprintSet* fingerprints_load(const char *path) {
+    FingerprintSet *set = fingerprints_new();
+    if (!set) return NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return set;
+
+    // Formato: magic de 8 bytes, quantidade (uint64) e os registros ordenados
+    char magic[8];
+    uint64_t count = 0;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              memcmp(magic, FINGERPRINT_MAGIC, sizeof(magic)) == 0 &&
+              fread(&count, sizeof(count), 1, file) == 1;
+    if (ok && count > 0) {
+        set->rows = malloc(count * sizeof(RowFingerprint));
+        set->seen = calloc(count, 1);
+        ok = set->rows && set->seen && fread(set->rows, sizeof(RowFingerprint), count, file) == count;
+        if (ok) set->count = set->capacity = count;
+    }
+    fclose(file);
+
+    if (!ok) {
+        logger_log(LOG_WARNING, "Fingerprints inválidos em %s: o arquivo será reimportado por completo", path);
+        free(set->rows);
+        free(set->seen);
+        memset(set, 0, sizeof(*set));
+    }
+    return set;
+}
+
+bool fingerprints_add(FingerprintSet *set, const char *key, size_t key_length, uint64_t fingerprint) {
+    if (!set || !key) return false;
+    if (set->count == set->capacity) {
+        size_t capacity = set->capacity ? set->capacity * 2 : 4096;
+        RowFingerprint *rows = realloc(set->rows, capacity * sizeof(RowFingerprint));
+        if (!rows) return false;
+        set->rows = rows;
+        set->capacity = capacity;
+    }
+
+    RowFingerprint *row = &set->rows[set->count++];
+    memset(row->key, 0, sizeof(row->key));
+    memcpy(row->key, key, key_length < FINGERPRINT_KEY_SIZE - 1 ? key_length : FINGERPRINT_KEY_SIZE - 1);
+    row->fingerprint = fingerprint;
+    return true;
+}
+
+void fingerprints_sort(FingerprintSet *set) {
+    if (set && set->count > 1) qsort(set->rows, set->count, sizeof(RowFingerprint), compare_rows);
+}
+
+long fingerprints_find(const FingerprintSet *set, const char *key, size_t key_length) {
+    if (!set || set->count == 0) return -1;
+
+    RowFingerprint probe;
+    memset(probe.key, 0, sizeof(probe.key));
+    memcpy(probe.key, key, key_length < FINGERPRINT_KEY_SIZE - 1 ? key_length : FINGERPRINT_KEY_SIZE - 1);
+
+    RowFingerprint *found = bsearch(&probe, set->rows, set->count, sizeof(RowFingerprint), compare_rows);
+    return found ? (long)(found - set->rows) : -1;
+}
+
+bool fingerprints_save(FingerprintSet *set, const char *path) {
+    if (!set) return false;
+    qsort(set->rows, set->count, sizeof(RowFingerprint), compare_rows);
+
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        logger_log(LOG_ERROR, "Erro ao gravar fingerprints: %s", tmp_path);
+        return false;
+    }
+
+    uint64_t count = set->count;
+    bool ok = fwrite(FINGERPRINT_MAGIC, 1, 8, file) == 8 &&
+              fwrite(&count, sizeof(count), 1, file) == 1 &&
+              (count == 0 || fwrite(set->rows, sizeof(RowFingerprint), count, file) == count);
+    ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+    ok = (fclose(file) == 0) && ok;
+    if (ok && rename(tmp_path, path) != 0) ok = false;
+    if (!ok) logger_log(LOG_ERROR, "Erro ao gravar fingerprints: %s", path);
+    return ok;
+}
+
+void fingerprints_free(FingerprintSet *set) {
+    if (!set) return;
+    free(set->rows);
+    free(set->seen);
+    free(set);
+}
@@ -0,0 +1,46 @@
+#ifndef ROW_FINGERPRINTS_H
+#define ROW_FINGERPRINTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FINGERPRINT_KEY_SIZE 24
+
+// Fingerprint de uma linha, identificada pela chave (cpf)
+typedef struct {
+    char key[FINGERPRINT_KEY_SIZE];
+    uint64_t fingerprint;
+} RowFingerprint;
+
+// Conjunto de fingerprints de um arquivo, ordenado pela chave
+typedef struct {
+    RowFingerprint *rows;
+    size_t count;
+    size_t capacity;
+    unsigned char *seen;   // Marca as linhas reencontradas na importação atual
+} FingerprintSet;
+
+// Carrega os fingerprints gravados na última importação do arquivo.
+// Um arquivo inexistente resulta em conjunto vazio.
+FingerprintSet* fingerprints_load(const char *path);
+
+// Cria um conjunto vazio para acumular os fingerprints da importação atual
+FingerprintSet* fingerprints_new();
+
+// Adiciona um fingerprint (o conjunto é ordenado ao gravar)
+bool fingerprints_add(FingerprintSet *set, const char *key, size_t key_length, uint64_t fingerprint);
+
+// Ordena pela chave, para permitir a busca em um conjunto montado com fingerprints_add
+void fingerprints_sort(FingerprintSet *set);
+
+// Busca binária pela chave; retorna o índice ou -1
+long fingerprints_find(const FingerprintSet *set, const char *key, size_t key_length);
+
+// Ordena e grava o conjunto de forma atômica
+bool fingerprints_save(FingerprintSet *set, const char *path);
+
+// Libera o conjunto
+void fingerprints_free(FingerprintSet *set);
+
+#endif // ROW_FINGERPRINTS_H
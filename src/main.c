@@ -1,32 +1,141 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <pthread.h>
-#include <dirent.h>
 #include <unistd.h>
 #include <json-c/json.h>
 #include <mongoc/mongoc.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <signal.h>
 
 #include "config/config_loader.h"
 #include "mongodb/mongodb_client.h"
+#include "mongodb/shard_router.h"
+#include "mongodb/rate_limiter.h"
 #include "utils/memory_manager.h"
 #include "utils/logger.h"
 #include "utils/string_utils.h"
+#include "utils/thread_placement.h"
+#include "data/field_mapping.h"
+#include "csv/file_reader.h"
+#include "csv/stream_reader.h"
+#include "csv/file_scheduler.h"
+#include "utils/trace.h"
+#include "utils/hash.h"
+#include "utils/encoding.h"
+#include "data/import_manifest.h"
+#include "data/row_fingerprints.h"
+#include "data/load_digest.h"
+#include "data/reject_writer.h"
+#include "data/pending_rows.h"
+#include "mongodb/collection_verifier.h"
 
 #define MAX_THREADS 16
+#define MAX_STREAMS 16
+#define CONFIG_PATH "config/config.json"
+#define PROGRESS_INTERVAL 1000  // Linhas por lote de progresso/trace
 #define LOG_WARN 2  // Adicionando definição do LOG_WARN
+#define INCREMENTAL_KEY_FIELD "cpf"  // Chave das linhas na importação incremental
+#define VERIFY_KEY_FIELD "cpf"       // Chave dos digests e das faixas da verificação
+#define VERIFY_LENGTH_FIELD "nome"   // Campo de texto cujo tamanho entra no digest
 
 // Variáveis globais para contagem
 static int total_lines_read = 0;
 static int total_documents_inserted = 0;
+static int total_documents_updated = 0;
+static int total_documents_deleted = 0;
+static int total_files_unchanged = 0;
+static long total_invalid_sequences = 0;
+static LoadDigest total_digest;
+static SourceDigest *source_digests = NULL;  // Digest por arquivo ou fluxo, só com verificação
+static int source_digest_count = 0;
+static int verify_key_field = -1;     // Índices no mapeamento; -1 sem verificação
+static int verify_length_field = -1;
+static double worker_tail_seconds[MAX_THREADS];  // Ociosidade de cada worker de arquivos no fim
+static double worker_wait_seconds[MAX_THREADS];  // Espera por arquivos a publicar, antes de roubar
+static int import_worker_count = 0;
 static pthread_mutex_t count_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 typedef struct {
-    char *filename;
+    char *filename;            // Arquivo que o worker processa como dono
     Config *config;
+    const FieldMapping *mapping;
+    ImportManifest *manifest;  // NULL fora do modo incremental
+    ShardRouter *router;       // NULL sem roteamento por shard
+    int key_field;             // Campo do mapeamento usado como chave incremental
+    InputEncoding encoding;    // Codificação dos arquivos de entrada
+    FileScheduler *scheduler;
+    int worker_index;
+    struct timespec finished;  // Quando o worker ficou sem trabalho
+    double steal_wait_seconds; // Tempo esperando arquivos entregues serem publicados
+    bool failed;               // Algum arquivo ou trecho não foi importado por completo
 } ThreadData;
 
+// Estado da importação incremental de um arquivo
+typedef struct {
+    bool enabled;
+    off_t size;
+    int64_t mtime_ns;
+    uint64_t content_hash;
+    FingerprintSet *previous;   // Fingerprints da última importação
+    FingerprintSet *current;    // Fingerprints desta importação
+    char fingerprint_path[512];
+    int inserted;
+    int updated;
+    int deleted;
+    int unchanged;
+    bool incomplete;            // Erro de leitura ou fingerprint que não coube na memória: estado não é salvo
+} DeltaState;
+
+// Arquivo alterado aguardando as remoções: os cpf que sumiram só são removidos
+// depois que todos os arquivos enviaram suas inserções e atualizações
+typedef struct {
+    char *filename;
+    DeltaState delta;
+    bool ok;           // Inserções e atualizações do arquivo foram aceitas
+} PendingDelta;
+
+static PendingDelta *pending_deltas = NULL;  // Protegido por count_mutex
+static int pending_delta_count = 0;
+static bool delta_keys_unknown = false;      // Algum arquivo alterado sem todas as chaves conhecidas
+
+// Resultado de delta_begin
+typedef enum {
+    DELTA_START_PROCESS,     // Arquivo novo ou alterado (ou fora do modo incremental)
+    DELTA_START_UNCHANGED,   // Arquivo igual ao da última importação
+    DELTA_START_ERROR        // Não foi possível preparar a comparação
+} DeltaStart;
+
+typedef enum {
+    DELTA_INSERT,
+    DELTA_UPDATE,
+    DELTA_UNCHANGED,
+    DELTA_INVALID
+} DeltaAction;
+
+// Fluxo de entrada (stdin ou pipe nomeado) e o plano do seu cabeçalho
+typedef struct {
+    StreamReader *reader;
+    ColumnPlan *plan;       // NULL enquanto não resolvido ou se o cabeçalho foi rejeitado
+    bool resolved;
+    pthread_mutex_t mutex;
+} StreamInput;
+
+typedef struct {
+    Config *config;
+    const FieldMapping *mapping;
+    ShardRouter *router;
+    StreamInput *inputs;
+    int input_count;
+    ChunkQueue *queue;
+    InputEncoding encoding;
+    int worker_index;
+    bool failed;            // Algum bloco foi descartado ou alguma linha recusada na escrita
+} StreamWorkerData;
+
 // Função para verificar se um arquivo segue o padrão pagina_nnnn.csv
 bool is_valid_filename(const char* filename) {
     if (!filename) return false;
@@ -45,31 +154,6 @@ bool is_valid_filename(const char* filename) {
     return true;
 }
 
-// Função para comparar nomes de arquivos
-int compare_files(const void *a, const void *b) {
-    return strcmp(*(const char **)a, *(const char **)b);
-}
-
-// Função para remover aspas de uma string
-char* remove_quotes(const char* str) {
-    if (!str) return NULL;
-    
-    size_t len = strlen(str);
-    if (len < 2) return strdup(str);
-    
-    // Verifica se começa e termina com aspas
-    if (str[0] == '"' && str[len-1] == '"') {
-        char* result = malloc(len-1);
-        if (!result) return NULL;
-        
-        strncpy(result, str+1, len-2);
-        result[len-2] = '\0';
-        return result;
-    }
-    
-    return strdup(str);
-}
-
 // Função para ler os campos do arquivo fields.txt
 char** read_fields_from_file(const char* filename, int* field_count) {
     FILE* file = fopen(filename, "r");
@@ -102,413 +186,1279 @@ char** read_fields_from_file(const char* filename, int* field_count) {
     return fields;
 }
 
-// Função para encontrar o índice de um campo no cabeçalho
-int find_field_index(char** header, int header_count, const char* field_name) {
-    for (int i = 0; i < header_count; i++) {
-        if (header[i] && strcmp(header[i], field_name) == 0) {
-            return i;
+// Verifica se um contato (telefone ou email) tem conteúdo útil
+static bool is_valid_contact(const FieldSpan *value) {
+    if (value->length == 0) return false;
+    if (value->length == 1 && (value->start[0] == ' ' || value->start[0] == '-')) return false;
+    return true;
+}
+
+// Adiciona um array de contatos a partir das colunas resolvidas para o arquivo
+static void append_contacts(bson_t *contatos, const char *key_name, const int *columns, int column_count,
+                            const FieldSpan *fields, int field_count) {
+    bson_t array;
+    BSON_APPEND_ARRAY_BEGIN(contatos, key_name, &array);
+    int array_index = 0;
+
+    for (int i = 0; i < column_count; i++) {
+        int column = columns[i];
+        if (column >= 0 && column < field_count && is_valid_contact(&fields[column])) {
+            char key[8];
+            bson_snprintf(key, sizeof(key), "%d", array_index++);
+            bson_append_utf8(&array, key, -1, fields[column].start, fields[column].length);
         }
     }
-    return -1;
+    bson_append_array_end(contatos, &array);
 }
 
-// Função para carregar o mapeamento de campos
-struct json_object* load_field_mapping() {
-    struct json_object* mapping = json_object_from_file("config/field_mapping.json");
-    if (!mapping) {
-        logger_log(LOG_ERROR, "Erro ao carregar mapeamento de campos");
-        return NULL;
+// Monta o documento de uma linha usando o plano de colunas do arquivo
+static void build_document(const FieldMapping *mapping, const ColumnPlan *plan,
+                           const FieldSpan *fields, int field_count, bson_t *doc) {
+    // Adiciona campos básicos
+    for (int i = 0; i < mapping->field_count; i++) {
+        int column = plan->field_columns[i];
+        if (column >= 0 && column < field_count) {
+            bson_append_utf8(doc, mapping->fields[i].name, -1, fields[column].start, fields[column].length);
+        } else {
+            BSON_APPEND_UTF8(doc, mapping->fields[i].name, "");
+        }
     }
-    return mapping;
+
+    // Cria o documento de contatos
+    bson_t contatos;
+    BSON_APPEND_DOCUMENT_BEGIN(doc, "contatos", &contatos);
+    append_contacts(&contatos, "telefones", plan->telefone_columns, mapping->telefone_count, fields, field_count);
+    append_contacts(&contatos, "emails", plan->email_columns, mapping->email_count, fields, field_count);
+    bson_append_document_end(doc, &contatos);
 }
 
-void *process_file(void *arg) {
-    ThreadData *data = (ThreadData*)arg;
-    if (!data || !data->filename || !data->config) {
-        logger_log(LOG_ERROR, "Dados da thread inválidos");
-        return NULL;
+// Localiza os campos só até a última coluna usada pelo plano e remove as
+// aspas apenas das colunas referenciadas. Retorna -1 se a linha não pôde ser dividida.
+static int parse_row(const ColumnPlan *plan, const char *line, size_t length, FieldSpan *fields) {
+    TRACE_BEGIN(TRACE_SPLIT);
+    int field_count = split_fields_lazy(line, length, ';', plan->max_column, fields);
+    TRACE_END(TRACE_SPLIT);
+    if (field_count <= 0 && plan->max_column >= 0) return -1;
+
+    TRACE_BEGIN(TRACE_UNQUOTE);
+    for (int i = 0; i < plan->needed_count && plan->needed_columns[i] < field_count; i++) {
+        span_unquote(&fields[plan->needed_columns[i]]);
     }
+    TRACE_END(TRACE_UNQUOTE);
+    return field_count;
+}
 
-    // Carrega o mapeamento de campos
-    struct json_object* mapping = load_field_mapping();
-    if (!mapping) {
-        return NULL;
+// Acumula no digest de verificação a linha que foi enviada ao MongoDB
+static DigestRow row_digest(const ColumnPlan *plan, const FieldSpan *fields, int field_count) {
+    DigestRow row = { .range = -1 };
+    if (verify_key_field < 0) return row;
+
+    FieldSpan key = { "", 0 };
+    FieldSpan text = { "", 0 };
+    int column = plan->field_columns[verify_key_field];
+    if (column >= 0 && column < field_count) key = fields[column];
+    column = verify_length_field >= 0 ? plan->field_columns[verify_length_field] : -1;
+    if (column >= 0 && column < field_count) text = fields[column];
+    return load_digest_row(key.start, (size_t)key.length, text.start, (size_t)text.length);
+}
+
+// Linhas entregues aos lotes de escrita de um worker e ainda não confirmadas.
+// Se o envio de um lote falhar, todas as linhas dele vão para a quarentena.
+typedef struct {
+    PendingRows *rows;
+    RejectWriter *rejects;
+    LoadDigest *digests;    // Digest de cada origem (arquivo ou fluxo) do worker
+    int rejected;           // Linhas recusadas pelo servidor
+} WriteBatch;
+
+// Guarda a linha antes de entregá-la ao lote e já a soma ao digest da origem.
+// Sem memória para a cópia, a linha vai para a quarentena e o tag é -1.
+static int write_batch_add(WriteBatch *batch, const char *source, long line_number, const char *line,
+                           size_t length, int origin, const DigestRow *digest) {
+    int tag = pending_rows_add(batch->rows, source, line_number, line, length, origin, digest);
+    if (tag < 0) {
+        reject_writer_add(batch->rejects, source, line_number, REJECT_MEMORY, line, length);
+        return -1;
     }
+    load_digest_add_row(&batch->digests[origin], digest);
+    return tag;
+}
 
-    char filepath[256];
-    snprintf(filepath, sizeof(filepath), "files_csv/%s", data->filename);
+// Conclusão de uma linha: recusada, sai do digest e vai para a quarentena
+static void write_batch_done(void *context, int tag, bool written) {
+    WriteBatch *batch = (WriteBatch*)context;
+    const PendingRow *row = pending_rows_get(batch->rows, tag);
+    if (!row) return;
 
-    // Inicializa o cliente MongoDB
-    char uri[256];
-    snprintf(uri, sizeof(uri), "mongodb://%s:%s@%s:%d",
-        data->config->mongodb_username,
-        data->config->mongodb_password,
-        data->config->mongodb_host,
-        data->config->mongodb_port);
+    if (!written) {
+        reject_writer_add(batch->rejects, row->source, row->line_number, REJECT_WRITE, row->line, row->length);
+        load_digest_remove_row(&batch->digests[row->origin], &row->digest);
+        batch->rejected++;
+    }
+    pending_rows_release(batch->rows, tag);
+}
 
-    MongoDBClient *client = mongodb_client_init(uri, 
-        data->config->mongodb_database,
-        data->config->mongodb_collection);
+// Resultado de uma operação no lote do cliente. Enquanto o lote acumula, uma
+// falha recusou só a linha atual; depois do envio, o resultado vale para
+// todas as linhas pendentes.
+static void write_batch_bulk_result(WriteBatch *batch, MongoDBClient *client, int tag, bool ok) {
+    if (client->bulk_pending > 0) {
+        if (!ok && tag >= 0) write_batch_done(batch, tag, false);
+        return;
+    }
+    for (int pending = pending_rows_next(batch->rows, -1); pending >= 0; pending = pending_rows_next(batch->rows, pending)) {
+        write_batch_done(batch, pending, ok);
+    }
+}
 
-    if (!client) {
-        logger_log(LOG_ERROR, "Erro ao inicializar cliente MongoDB para arquivo: %s", filepath);
-        json_object_put(mapping);
-        return NULL;
+// Soma o digest de um trecho ao da sua origem; chamada com count_mutex travado
+static void record_source_digest(const char *source, const LoadDigest *digest) {
+    if (verify_key_field < 0) return;
+
+    for (int i = 0; i < source_digest_count; i++) {
+        if (strcmp(source_digests[i].source, source) == 0) {
+            load_digest_merge(&source_digests[i].digest, digest);
+            return;
+        }
+    }
+    SourceDigest *grown = realloc(source_digests, (source_digest_count + 1) * sizeof(SourceDigest));
+    char *name = strdup(source);
+    if (!grown || !name) {
+        if (grown) source_digests = grown;
+        free(name);
+        logger_log(LOG_WARNING, "Sem memória para a contagem por arquivo de %s", source);
+        return;
     }
+    source_digests = grown;
+    source_digests[source_digest_count].source = name;
+    source_digests[source_digest_count].digest = *digest;
+    source_digest_count++;
+}
 
-    // Abre o arquivo CSV
-    FILE *file = fopen(filepath, "r");
-    if (!file) {
-        logger_log(LOG_ERROR, "Erro ao abrir arquivo: %s", filepath);
-        mongodb_client_close(client);
-        json_object_put(mapping);
-        return NULL;
+// Monta a URI do MongoDB a partir da configuração
+static void config_uri(const Config *config, char *uri, size_t size) {
+    char hosts[256];
+    snprintf(hosts, sizeof(hosts), "%s:%d", config->mongodb_host, config->mongodb_port);
+    mongodb_build_uri(uri, size, hosts, config->mongodb_username, config->mongodb_password, NULL);
+}
+
+// Cria o cliente MongoDB de um worker a partir da configuração
+static MongoDBClient* open_client(const Config *config) {
+    char uri[512];
+    config_uri(config, uri, sizeof(uri));
+
+    MongoDBClient *client = mongodb_client_init(uri, config->mongodb_database, config->mongodb_collection);
+    if (client) mongodb_client_set_batch_size(client, config->batch_size);
+    return client;
+}
+
+// Cria o escritor por shard de um worker; NULL sem roteamento por shard
+static ShardedWriter* open_sharded_writer(const Config *config, ShardRouter *router) {
+    if (!router) return NULL;
+    return sharded_writer_new(router, config->mongodb_database, config->mongodb_collection,
+        config->mongodb_username, config->mongodb_password, config->shard_direct_connections,
+        config->batch_size);
+}
+
+// Decide se o arquivo precisa ser processado no modo incremental
+static DeltaStart delta_begin(ThreadData *data, const char *filepath, DeltaState *delta) {
+    memset(delta, 0, sizeof(*delta));
+    if (!data->manifest) return DELTA_START_PROCESS;
+
+    // Sem comparação, o arquivo seria inserido de novo por inteiro: nunca segue sem ela
+    struct stat st;
+    if (stat(filepath, &st) != 0) {
+        logger_log(LOG_ERROR, "Erro ao obter tamanho e mtime de %s", data->filename);
+        return DELTA_START_ERROR;
+    }
+    delta->size = st.st_size;
+    delta->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+    // Mesmo tamanho e mtime: nem o conteúdo é lido
+    ManifestEntry entry;
+    bool known = manifest_find(data->manifest, data->filename, &entry);
+    if (known && entry.size == delta->size && entry.mtime_ns == delta->mtime_ns) {
+        logger_log(LOG_INFO, "Arquivo %s inalterado (tamanho e mtime), ignorado", data->filename);
+        return DELTA_START_UNCHANGED;
     }
 
-    // Lê o cabeçalho (primeira linha)
-    char *line = NULL;
-    size_t line_size = 0;
-    if (getline(&line, &line_size, file) == -1) {
-        logger_log(LOG_ERROR, "Arquivo vazio: %s", filepath);
-        fclose(file);
-        mongodb_client_close(client);
-        json_object_put(mapping);
-        return NULL;
+    if (!file_content_hash(filepath, &delta->content_hash)) {
+        logger_log(LOG_ERROR, "Erro ao calcular hash de %s", data->filename);
+        return DELTA_START_ERROR;
+    }
+    if (known && entry.content_hash == delta->content_hash) {
+        manifest_update(data->manifest, data->filename, delta->size, delta->mtime_ns, delta->content_hash);
+        logger_log(LOG_INFO, "Arquivo %s inalterado (hash do conteúdo), ignorado", data->filename);
+        return DELTA_START_UNCHANGED;
     }
 
-    // Verifica se há mais linhas além do cabeçalho
-    if (getline(&line, &line_size, file) == -1) {
-        logger_log(LOG_ERROR, "Arquivo contém apenas cabeçalho: %s", filepath);
-        fclose(file);
-        mongodb_client_close(client);
-        json_object_put(mapping);
-        return NULL;
+    snprintf(delta->fingerprint_path, sizeof(delta->fingerprint_path), "%s/%s.fp",
+        data->config->state_dir, data->filename);
+    delta->previous = fingerprints_load(delta->fingerprint_path);
+    delta->current = fingerprints_new();
+    if (!delta->previous || !delta->current) {
+        fingerprints_free(delta->previous);
+        fingerprints_free(delta->current);
+        delta->previous = delta->current = NULL;
+        logger_log(LOG_ERROR, "Erro ao preparar fingerprints de %s", data->filename);
+        return DELTA_START_ERROR;
+    }
+    if (known && delta->previous->count == 0) {
+        logger_log(LOG_WARNING, "Arquivo %s consta no manifesto mas não tem fingerprints: todas as linhas serão inseridas",
+            data->filename);
     }
 
-    int count = 0;
-    int file_lines = 0;
-    int skipped_lines = 0;
+    delta->enabled = true;
+    logger_log(LOG_INFO, "Arquivo %s alterado: comparando com %zu fingerprints anteriores",
+        data->filename, delta->previous->count);
+    return DELTA_START_PROCESS;
+}
+
+// Classifica a linha comparando seu fingerprint com o da importação anterior
+static DeltaAction delta_classify(DeltaState *delta, const ColumnPlan *plan, int key_field,
+                                  const FieldSpan *fields, int field_count, const char *line, size_t length,
+                                  const FieldSpan **key) {
+    int column = plan->field_columns[key_field];
+    if (column < 0 || column >= field_count || fields[column].length == 0) {
+        return DELTA_INVALID;
+    }
+    *key = &fields[column];
+
+    uint64_t fingerprint = hash_bytes(line, length, 0);
+    if (!fingerprints_add(delta->current, (*key)->start, (size_t)(*key)->length, fingerprint)) {
+        delta->incomplete = true;
+    }
+
+    long previous = fingerprints_find(delta->previous, (*key)->start, (size_t)(*key)->length);
+    if (previous < 0) return DELTA_INSERT;
+
+    delta->previous->seen[previous] = 1;
+    return delta->previous->rows[previous].fingerprint == fingerprint ? DELTA_UNCHANGED : DELTA_UPDATE;
+}
 
-    // Processa a primeira linha de dados que já foi lida
-    file_lines++;
-    // Remove quebra de linha do final
-    line[strcspn(line, "\n")] = 0;
+// Substitui (com upsert) o documento da chave informada
+static bool delta_replace(MongoDBClient *client, const FieldSpan *key, const bson_t *doc) {
+    bson_t selector;
+    bson_init(&selector);
+    bson_append_utf8(&selector, INCREMENTAL_KEY_FIELD, -1, key->start, key->length);
+    bool result = mongodb_client_bulk_replace(client, &selector, doc);
+    bson_destroy(&selector);
+    return result;
+}
+
+static void delta_free(DeltaState *delta) {
+    fingerprints_free(delta->previous);
+    fingerprints_free(delta->current);
+    delta->previous = delta->current = NULL;
+}
+
+// Arquivo alterado que não chegou a ser lido: suas chaves ficam desconhecidas
+static void delta_abandon(DeltaState *delta) {
+    if (delta->enabled) {
+        pthread_mutex_lock(&count_mutex);
+        delta_keys_unknown = true;
+        pthread_mutex_unlock(&count_mutex);
+    }
+    delta_free(delta);
+}
+
+// Envia o lote de upserts do arquivo e deixa as remoções para delta_commit.
+// Os fingerprints passam para a lista de pendentes.
+static void delta_finish(ThreadData *data, DeltaState *delta, MongoDBClient *client, bool ok) {
+    if (!delta->enabled) return;
+
+    ok = mongodb_client_bulk_flush(client) && ok;
+    if (delta->incomplete) {
+        logger_log(LOG_ERROR, "Arquivo %s: nem todas as chaves foram lidas ou guardadas", data->filename);
+        ok = false;
+    }
+    if (!ok) {
+        logger_log(LOG_ERROR, "Arquivo %s: falha nas escritas incrementais, estado não atualizado", data->filename);
+    }
 
-    // Cria um documento BSON simples
-    bson_t *doc = bson_new();
-    if (!doc) {
-        logger_log(LOG_ERROR, "Erro ao criar documento BSON na linha %d", file_lines);
-        skipped_lines++;
+    pthread_mutex_lock(&count_mutex);
+    if (delta->incomplete) delta_keys_unknown = true;
+    PendingDelta *pending = realloc(pending_deltas, (pending_delta_count + 1) * sizeof(PendingDelta));
+    char *filename = strdup(data->filename);
+    if (pending && filename) {
+        pending_deltas = pending;
+        pending_deltas[pending_delta_count].filename = filename;
+        pending_deltas[pending_delta_count].delta = *delta;
+        pending_deltas[pending_delta_count].ok = ok;
+        pending_delta_count++;
+        delta->previous = delta->current = NULL;
     } else {
-        // Divide a linha em campos
-        char **fields = NULL;
-        int field_count = split_string(line, ";", &fields);
-        if (field_count <= 0 || !fields) {
-            logger_log(LOG_ERROR, "Erro ao dividir campos na linha %d", file_lines);
-            skipped_lines++;
-            bson_destroy(doc);
-        } else {
-            // Remove aspas de todos os campos
-            for (int i = 0; i < field_count; i++) {
-                if (fields[i]) {
-                    char* clean_field = remove_quotes(fields[i]);
-                    if (clean_field) {
-                        free(fields[i]);
-                        fields[i] = clean_field;
-                    }
-                }
-            }
+        if (pending) pending_deltas = pending;
+        free(filename);
+        logger_log(LOG_ERROR, "Arquivo %s: sem memória para as remoções incrementais, estado não atualizado",
+            data->filename);
+    }
+    pthread_mutex_unlock(&count_mutex);
+}
 
-            // Adiciona campos básicos
-            struct json_object* fields_obj;
-            if (!json_object_object_get_ex(mapping, "fields", &fields_obj)) {
-                logger_log(LOG_ERROR, "Erro ao obter campos do mapeamento");
-                skipped_lines++;
-                bson_destroy(doc);
-                free_string_array(fields, field_count);
-            } else {
-                struct json_object_iterator it = json_object_iter_begin(fields_obj);
-                struct json_object_iterator itEnd = json_object_iter_end(fields_obj);
+// Indica se a chave aparece em algum arquivo processado nesta execução
+static bool delta_key_seen(const char *key) {
+    for (int i = 0; i < pending_delta_count; i++) {
+        if (fingerprints_find(pending_deltas[i].delta.current, key, strlen(key)) >= 0) return true;
+    }
+    return false;
+}
 
-                while (!json_object_iter_equal(&it, &itEnd)) {
-                    const char* field_name = json_object_iter_peek_name(&it);
-                    struct json_object* field_index_obj = json_object_iter_peek_value(&it);
-                    int field_index = json_object_get_int(field_index_obj) - 1;  // Ajusta para índice 0-based
+// Com todos os upserts já enviados, remove os cpf que sumiram dos arquivos
+// alterados e grava o novo estado de cada arquivo. Um cpf que continua em
+// algum arquivo processado nesta execução (mudou de arquivo) não é removido.
+// Se algum arquivo alterado não teve todas as chaves lidas, nada é removido.
+// Retorna false se algum arquivo ficou com o estado da importação anterior.
+static bool delta_commit(const Config *config, ImportManifest *manifest) {
+    if (pending_delta_count == 0) return !delta_keys_unknown;
 
-                    if (field_index >= 0 && field_index < field_count && fields && fields[field_index]) {
-                        BSON_APPEND_UTF8(doc, field_name, fields[field_index]);
-                    } else {
-                        BSON_APPEND_UTF8(doc, field_name, "");
-                    }
+    if (delta_keys_unknown) {
+        logger_log(LOG_ERROR, "Remoções incrementais adiadas: um arquivo alterado não foi lido por completo");
+    }
 
-                    json_object_iter_next(&it);
-                }
+    for (int i = 0; i < pending_delta_count; i++) {
+        fingerprints_sort(pending_deltas[i].delta.current);
+    }
 
-                // Cria o documento de contatos
-                bson_t contatos;
-                BSON_APPEND_DOCUMENT_BEGIN(doc, "contatos", &contatos);
-
-                // Adiciona telefones
-                struct json_object* contatos_obj;
-                if (!json_object_object_get_ex(mapping, "contatos", &contatos_obj)) {
-                    logger_log(LOG_ERROR, "Erro ao obter contatos do mapeamento");
-                    skipped_lines++;
-                    bson_destroy(doc);
-                    free_string_array(fields, field_count);
-                } else {
-                    struct json_object* telefones_array_obj;
-                    if (!json_object_object_get_ex(contatos_obj, "telefones", &telefones_array_obj)) {
-                        logger_log(LOG_ERROR, "Erro ao obter telefones do mapeamento");
-                        skipped_lines++;
-                        bson_destroy(doc);
-                        free_string_array(fields, field_count);
-                    } else {
-                        bson_t telefones;
-                        BSON_APPEND_ARRAY_BEGIN(&contatos, "telefones", &telefones);
-                        int telefone_index = 0;
-                        int telefones_count = json_object_array_length(telefones_array_obj);
-
-                        for (int i = 0; i < telefones_count; i++) {
-                            struct json_object* telefone_index_obj = json_object_array_get_idx(telefones_array_obj, i);
-                            if (!telefone_index_obj) continue;
-
-                            int telefone_field_index = json_object_get_int(telefone_index_obj) - 1;  // Ajusta para índice 0-based
-                            if (telefone_field_index >= 0 && telefone_field_index < field_count && 
-                                fields[telefone_field_index] && 
-                                strlen(fields[telefone_field_index]) > 0 && 
-                                strcmp(fields[telefone_field_index], " ") != 0 && 
-                                strcmp(fields[telefone_field_index], "-") != 0) {
-                                char key[8];
-                                bson_snprintf(key, sizeof(key), "%d", telefone_index++);
-                                BSON_APPEND_UTF8(&telefones, key, fields[telefone_field_index]);
-                            }
-                        }
-                        bson_append_array_end(&contatos, &telefones);
-
-                        // Adiciona emails
-                        struct json_object* emails_array_obj;
-                        if (!json_object_object_get_ex(contatos_obj, "emails", &emails_array_obj)) {
-                            logger_log(LOG_ERROR, "Erro ao obter emails do mapeamento");
-                            skipped_lines++;
-                            bson_destroy(doc);
-                            free_string_array(fields, field_count);
-                        } else {
-                            bson_t emails;
-                            BSON_APPEND_ARRAY_BEGIN(&contatos, "emails", &emails);
-                            int email_index = 0;
-                            int emails_count = json_object_array_length(emails_array_obj);
-
-                            for (int i = 0; i < emails_count; i++) {
-                                struct json_object* email_index_obj = json_object_array_get_idx(emails_array_obj, i);
-                                if (!email_index_obj) continue;
-
-                                int email_field_index = json_object_get_int(email_index_obj) - 1;  // Ajusta para índice 0-based
-                                if (email_field_index >= 0 && email_field_index < field_count && 
-                                    fields[email_field_index] && 
-                                    strlen(fields[email_field_index]) > 0 && 
-                                    strcmp(fields[email_field_index], " ") != 0 && 
-                                    strcmp(fields[email_field_index], "-") != 0) {
-                                    char key[8];
-                                    bson_snprintf(key, sizeof(key), "%d", email_index++);
-                                    BSON_APPEND_UTF8(&emails, key, fields[email_field_index]);
-                                }
-                            }
-                            bson_append_array_end(&contatos, &emails);
-
-                            bson_append_document_end(doc, &contatos);
-
-                            if (!mongodb_client_insert(client, doc)) {
-                                logger_log(LOG_ERROR, "Erro ao inserir documento na linha %d", file_lines);
-                                skipped_lines++;
-                            } else {
-                                count++;
-                                if (count % 1000 == 0) {
-                                    logger_log(LOG_INFO, "Arquivo %s: %d registros importados", data->filename, count);
-                                }
-                            }
-                        }
-                    }
-                }
+    MongoDBClient *client = open_client(config);
+    if (!client) {
+        logger_log(LOG_ERROR, "Erro ao inicializar cliente MongoDB para as remoções incrementais");
+    }
+    bool all_ok = !delta_keys_unknown;
+
+    for (int i = 0; i < pending_delta_count; i++) {
+        PendingDelta *pending = &pending_deltas[i];
+        DeltaState *delta = &pending->delta;
+        bool ok = pending->ok && client && !delta_keys_unknown;
+        int moved = 0;
+
+        for (size_t row = 0; ok && row < delta->previous->count; row++) {
+            if (delta->previous->seen[row]) continue;
+            const char *key = delta->previous->rows[row].key;
+            if (delta_key_seen(key)) {
+                moved++;
+                continue;
             }
-            free_string_array(fields, field_count);
+            bson_t selector;
+            bson_init(&selector);
+            BSON_APPEND_UTF8(&selector, INCREMENTAL_KEY_FIELD, key);
+            ok = mongodb_client_bulk_delete(client, &selector);
+            bson_destroy(&selector);
+            if (ok) delta->deleted++;
         }
-        bson_destroy(doc);
+        if (client) ok = mongodb_client_bulk_flush(client) && ok;
+
+        // Só registra o novo estado se todas as escritas foram aceitas;
+        // caso contrário o arquivo é comparado de novo na próxima execução
+        if (ok) {
+            ok = fingerprints_save(delta->current, delta->fingerprint_path) &&
+                 manifest_update(manifest, pending->filename, delta->size, delta->mtime_ns, delta->content_hash);
+        } else if (pending->ok) {
+            logger_log(LOG_ERROR, "Arquivo %s: falha nas remoções incrementais, estado não atualizado", pending->filename);
+        }
+
+        if (!ok) all_ok = false;
+        logger_log(LOG_INFO, "Arquivo %s: %d inseridos, %d atualizados, %d removidos, %d inalterados, %d mudaram de arquivo",
+            pending->filename, delta->inserted, delta->updated, delta->deleted, delta->unchanged, moved);
+        total_documents_deleted += delta->deleted;
+        delta_free(delta);
+        free(pending->filename);
     }
 
-    // Processa as demais linhas do arquivo
-    while (getline(&line, &line_size, file) != -1) {
-        file_lines++;
-        // Remove quebra de linha do final
-        line[strcspn(line, "\n")] = 0;
+    mongodb_client_close(client);
+    free(pending_deltas);
+    pending_deltas = NULL;
+    pending_delta_count = 0;
+    return all_ok;
+}
 
-        // Cria um documento BSON simples
-        bson_t *doc = bson_new();
-        if (!doc) {
-            logger_log(LOG_ERROR, "Erro ao criar documento BSON na linha %d", file_lines);
-            skipped_lines++;
+// Trabalho de um worker em um arquivo, como dono (abriu o arquivo e resolveu
+// o cabeçalho) ou como ajudante que roubou trechos
+typedef struct {
+    ThreadData *data;
+    FileJob *job;
+    const ColumnPlan *plan;
+    FileReader *file;
+    MongoDBClient *client;
+    ShardedWriter *sharded;    // NULL sem roteamento por shard ou no modo incremental
+    RejectWriter *rejects;
+    DeltaState *delta;         // Só o dono; o arquivo inteiro fica com ele no modo incremental
+    FieldSpan *fields;
+    TranscodeBuffer transcoded;
+    long invalid_sequences;
+    int count;
+    int lines;
+    int skipped_lines;
+    bool write_failed;
+    bool read_failed;
+    bool counting_lines;       // Só o dono: trechos contínuos desde o cabeçalho
+    off_t next_start;          // Início do trecho que continua o anterior
+    long line_number;          // Linhas de dados lidas até next_start
+    LoadDigest digest;
+    WriteBatch batch;          // Linhas nos lotes do escritor por shard ou do modo incremental
+} FileWork;
+
+// Parâmetros de leitura dos arquivos CSV
+static FileReaderConfig file_reader_config(const Config *config) {
+    FileReaderConfig reader_config = {
+        .backend = file_reader_parse_backend(config->io_backend),
+        .direct_io = config->io_direct,
+        .queue_depth = config->io_queue_depth,
+        .block_size = (size_t)config->io_block_size_kb * 1024
+    };
+    return reader_config;
+}
+
+// Prepara cliente, escritor por shard, quarentena e trechos de colunas do worker no arquivo
+static bool file_work_open(FileWork *work, ThreadData *data, FileJob *job, const ColumnPlan *plan,
+                           const char *reject_name, bool use_router) {
+    work->data = data;
+    work->job = job;
+    work->plan = plan;
+
+    work->client = open_client(data->config);
+    if (!work->client) {
+        logger_log(LOG_ERROR, "Erro ao inicializar cliente MongoDB para arquivo: %s", job->filename);
+        return false;
+    }
+
+    // Roteamento por shard: inserções agrupadas em lotes de um único shard
+    if (data->router && use_router) {
+        work->sharded = open_sharded_writer(data->config, data->router);
+        if (!work->sharded) {
+            logger_log(LOG_WARNING, "Arquivo %s: roteamento por shard indisponível, inserindo via mongos", job->filename);
+        }
+    }
+
+    work->rejects = reject_writer_new(data->config->rejects_dir, reject_name);
+    work->batch.rows = pending_rows_new();
+    work->batch.rejects = work->rejects;
+    work->batch.digests = &work->digest;
+    if (work->sharded) sharded_writer_on_done(work->sharded, write_batch_done, &work->batch);
+
+    // Trechos das colunas da linha atual, reaproveitados entre as linhas
+    work->fields = malloc((plan->max_column + 1 > 0 ? plan->max_column + 1 : 1) * sizeof(FieldSpan));
+    if (!work->fields || !work->batch.rows) {
+        // Desfaz o que já foi aberto: quem chamou só libera o que é seu
+        logger_log(LOG_ERROR, "Arquivo %s: memória insuficiente para o worker %d", job->filename, data->worker_index);
+        free(work->fields);
+        work->fields = NULL;
+        pending_rows_free(work->batch.rows);
+        work->batch.rows = NULL;
+        reject_writer_close(work->rejects);
+        work->rejects = NULL;
+        sharded_writer_free(work->sharded);
+        work->sharded = NULL;
+        mongodb_client_close(work->client);
+        work->client = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Processa as linhas do trecho [chunk_start, chunk_end) do leitor. Nas
+// rejeições, a linha é numerada no arquivo enquanto o dono lê trechos
+// seguidos; trechos roubados, ou do dono depois de um trecho roubado,
+// aparecem como <arquivo>@<offset>, numerados dentro do trecho.
+static void process_lines(FileWork *work, off_t chunk_start, off_t chunk_end) {
+    ThreadData *data = work->data;
+    const ColumnPlan *plan = work->plan;
+    DeltaState *delta = work->delta;
+
+    // Enquanto os trechos do dono seguem um ao outro desde o cabeçalho, a
+    // numeração continua a do arquivo; depois do primeiro salto, só resta
+    // numerar dentro do trecho
+    bool continues = work->counting_lines && chunk_start == work->next_start;
+    work->counting_lines = continues;
+    char source[288];
+    if (continues) {
+        snprintf(source, sizeof(source), "%s", work->job->filename);
+    } else {
+        snprintf(source, sizeof(source), "%s@%lld", work->job->filename, (long long)chunk_start);
+    }
+
+    char *line = NULL;
+    size_t length = 0;
+    long chunk_line = continues ? work->line_number : 0;
+    for (;;) {
+        TRACE_BEGIN(TRACE_READ);
+        ssize_t read = file_reader_getline(work->file, &line);
+        TRACE_END(TRACE_READ);
+        if (read == -1) break;
+
+        chunk_line++;
+        work->lines++;
+
+        // Converte a linha para UTF-8; linhas ASCII seguem sem cópia
+        TRACE_BEGIN(TRACE_DECODE);
+        const char *text = transcode_line(data->encoding, line, (size_t)read, &work->transcoded, &length,
+            &work->invalid_sequences);
+        TRACE_END(TRACE_DECODE);
+        if (!text) {
+            reject_writer_add(work->rejects, source, chunk_line, REJECT_MEMORY, line, (size_t)read);
+            work->skipped_lines++;
             continue;
         }
 
-        // Divide a linha em campos
-        char **fields = NULL;
-        int field_count = split_string(line, ";", &fields);
-        if (field_count <= 0 || !fields) {
-            logger_log(LOG_ERROR, "Erro ao dividir campos na linha %d", file_lines);
-            skipped_lines++;
-            bson_destroy(doc);
+        int field_count = parse_row(plan, text, length, work->fields);
+        if (field_count < 0) {
+            reject_writer_add(work->rejects, source, chunk_line, REJECT_SPLIT, line, (size_t)read);
+            work->skipped_lines++;
             continue;
         }
 
-        // Remove aspas de todos os campos
-        for (int i = 0; i < field_count; i++) {
-            if (fields[i]) {
-                char* clean_field = remove_quotes(fields[i]);
-                if (clean_field) {
-                    free(fields[i]);
-                    fields[i] = clean_field;
+        // No modo incremental, só linhas novas ou alteradas geram escrita
+        DeltaAction action = DELTA_INSERT;
+        const FieldSpan *key = NULL;
+        if (delta && delta->enabled) {
+            action = delta_classify(delta, plan, data->key_field, work->fields, field_count, text, length, &key);
+            if (action == DELTA_UNCHANGED || action == DELTA_INVALID) {
+                if (action == DELTA_UNCHANGED) {
+                    delta->unchanged++;
+                } else {
+                    reject_writer_add(work->rejects, source, chunk_line, REJECT_NO_KEY, line, (size_t)read);
+                    work->skipped_lines++;
                 }
+                TRACE_ROW_END();
+                continue;
             }
         }
 
-        // Adiciona campos básicos
-        struct json_object* fields_obj;
-        if (!json_object_object_get_ex(mapping, "fields", &fields_obj)) {
-            logger_log(LOG_ERROR, "Erro ao obter campos do mapeamento");
-            skipped_lines++;
-            bson_destroy(doc);
-            free_string_array(fields, field_count);
+        // Cria um documento BSON simples
+        bson_t *doc = bson_new();
+        if (!doc) {
+            reject_writer_add(work->rejects, source, chunk_line, REJECT_MEMORY, line, (size_t)read);
+            work->skipped_lines++;
             continue;
         }
 
-        struct json_object_iterator it = json_object_iter_begin(fields_obj);
-        struct json_object_iterator itEnd = json_object_iter_end(fields_obj);
+        TRACE_BEGIN(TRACE_BUILD);
+        build_document(data->mapping, plan, work->fields, field_count, doc);
+        TRACE_END(TRACE_BUILD);
+
+        // Em lote, a linha fica guardada até o servidor confirmar o envio
+        DigestRow digest = row_digest(plan, work->fields, field_count);
+        bool batched = work->sharded || (delta && delta->enabled);
+        int tag = -1;
+        if (batched) {
+            tag = write_batch_add(&work->batch, source, chunk_line, line, (size_t)read, 0, &digest);
+            if (tag < 0) {
+                bson_destroy(doc);
+                work->skipped_lines++;
+                continue;
+            }
+        }
 
-        while (!json_object_iter_equal(&it, &itEnd)) {
-            const char* field_name = json_object_iter_peek_name(&it);
-            struct json_object* field_index_obj = json_object_iter_peek_value(&it);
-            int field_index = json_object_get_int(field_index_obj) - 1;  // Ajusta para índice 0-based
+        // Linhas novas e alteradas vão como upsert pela chave: se o lote
+        // falhar no meio, a próxima execução reenvia sem duplicar documentos
+        bool written;
+        if (work->sharded) {
+            written = sharded_writer_insert(work->sharded, doc, tag);
+        } else if (!delta || !delta->enabled) {
+            written = mongodb_client_insert(work->client, doc);
+        } else {
+            written = delta_replace(work->client, key, doc);
+            write_batch_bulk_result(&work->batch, work->client, tag, written);
+            if (written && action == DELTA_INSERT) delta->inserted++;
+            if (written && action == DELTA_UPDATE) delta->updated++;
+        }
 
-            if (field_index >= 0 && field_index < field_count && fields && fields[field_index]) {
-                BSON_APPEND_UTF8(doc, field_name, fields[field_index]);
-            } else {
-                BSON_APPEND_UTF8(doc, field_name, "");
+        // Em lote, as linhas recusadas são descontadas ao final
+        if (!written) {
+            work->write_failed = true;
+            if (!batched) {
+                reject_writer_add(work->rejects, source, chunk_line, REJECT_WRITE, line, (size_t)read);
+                work->skipped_lines++;
+            }
+        }
+        if (written || batched) {
+            work->count++;
+            if (!batched) load_digest_add_row(&work->digest, &digest);
+            if (work->count % PROGRESS_INTERVAL == 0) {
+                logger_log(LOG_INFO, "Arquivo %s: %d registros importados pelo worker %d",
+                    work->job->filename, work->count, data->worker_index);
             }
-
-            json_object_iter_next(&it);
         }
 
-        // Cria o documento de contatos
-        bson_t contatos;
-        BSON_APPEND_DOCUMENT_BEGIN(doc, "contatos", &contatos);
+        bson_destroy(doc);
+        TRACE_ROW_END();
+    }
 
-        // Adiciona telefones
-        struct json_object* contatos_obj;
-        if (!json_object_object_get_ex(mapping, "contatos", &contatos_obj)) {
-            logger_log(LOG_ERROR, "Erro ao obter contatos do mapeamento");
-            skipped_lines++;
-            bson_destroy(doc);
-            free_string_array(fields, field_count);
-            continue;
+    if (continues) {
+        work->line_number = chunk_line;
+        work->next_start = chunk_end;
+    }
+
+    if (file_reader_failed(work->file)) {
+        logger_log(LOG_ERROR, "Arquivo %s: erro de leitura, trecho a partir do offset %lld incompleto",
+            work->job->filename, (long long)chunk_start);
+        work->read_failed = true;
+    }
+}
+
+// Envia os lotes pendentes, soma aos totais globais e libera o trabalho do worker no arquivo
+static void file_work_finish(FileWork *work) {
+    ThreadData *data = work->data;
+    if (work->sharded) {
+        // Só conta o que os shards confirmaram
+        if (!sharded_writer_flush(work->sharded)) {
+            logger_log(LOG_ERROR, "Arquivo %s: falha ao enviar lotes aos shards", work->job->filename);
         }
+        work->count = (int)sharded_writer_written(work->sharded);
+        sharded_writer_free(work->sharded);
+    } else {
+        work->count -= work->batch.rejected;
+    }
+    work->skipped_lines += work->batch.rejected;
+    if (work->batch.rejected > 0) work->write_failed = true;
+    if (work->write_failed || work->read_failed) data->failed = true;
 
-        struct json_object* telefones_array_obj;
-        if (!json_object_object_get_ex(contatos_obj, "telefones", &telefones_array_obj)) {
-            logger_log(LOG_ERROR, "Erro ao obter telefones do mapeamento");
-            skipped_lines++;
-            bson_destroy(doc);
-            free_string_array(fields, field_count);
-            continue;
+    if (work->invalid_sequences > 0) {
+        logger_log(LOG_WARNING, "Arquivo %s: %ld sequências inválidas em %s substituídas por U+FFFD",
+            work->job->filename, work->invalid_sequences, encoding_name(data->encoding));
+    }
+
+    pthread_mutex_lock(&count_mutex);
+    total_lines_read += work->lines;
+    total_invalid_sequences += work->invalid_sequences;
+    load_digest_merge(&total_digest, &work->digest);
+    record_source_digest(work->job->filename, &work->digest);
+    if (work->delta && work->delta->enabled) {
+        total_documents_inserted += work->delta->inserted;
+        total_documents_updated += work->delta->updated;
+    } else {
+        total_documents_inserted += work->count;
+    }
+    pthread_mutex_unlock(&count_mutex);
+
+    free(work->fields);
+    transcode_buffer_free(&work->transcoded);
+    pending_rows_free(work->batch.rows);
+    reject_writer_close(work->rejects);
+    mongodb_client_close(work->client);
+}
+
+// Processa um arquivo como dono: lê o cabeçalho, publica o plano para os
+// workers ociosos e importa os trechos que ainda não foram roubados
+static void process_file(ThreadData *data, FileJob *job) {
+    data->filename = job->filename;
+    TRACE_THREAD_BEGIN(job->filename);
+
+    char filepath[256];
+    snprintf(filepath, sizeof(filepath), "files_csv/%s", job->filename);
+
+    // Importação incremental: arquivos inalterados são ignorados por completo
+    DeltaState delta;
+    DeltaStart start_state = delta_begin(data, filepath, &delta);
+    if (start_state == DELTA_START_ERROR) {
+        logger_log(LOG_ERROR, "Arquivo %s não importado: falha ao preparar a importação incremental", job->filename);
+        data->failed = true;
+        pthread_mutex_lock(&count_mutex);
+        delta_keys_unknown = true;
+        pthread_mutex_unlock(&count_mutex);
+        TRACE_THREAD_END();
+        return;
+    }
+    if (start_state == DELTA_START_UNCHANGED) {
+        pthread_mutex_lock(&count_mutex);
+        total_files_unchanged++;
+        pthread_mutex_unlock(&count_mutex);
+        TRACE_THREAD_END();
+        return;
+    }
+
+    // Abre o arquivo CSV; as primeiras leituras já ficam em voo
+    FileReaderConfig reader_config = file_reader_config(data->config);
+    FileReader *file = file_reader_open(filepath, &reader_config);
+    if (!file) {
+        logger_log(LOG_ERROR, "Erro ao abrir arquivo: %s", filepath);
+        data->failed = true;
+        delta_abandon(&delta);
+        TRACE_THREAD_END();
+        return;
+    }
+    logger_log(LOG_DEBUG, "Arquivo %s: leitura via %s", job->filename, file_reader_backend_name(file));
+
+    // Lê o cabeçalho (primeira linha)
+    char *line = NULL;
+    ssize_t header_length = file_reader_getline(file, &line);
+    if (header_length == -1) {
+        if (file_reader_failed(file)) {
+            logger_log(LOG_ERROR, "Erro ao ler o cabeçalho de %s", filepath);
+            data->failed = true;
+        } else {
+            logger_log(LOG_ERROR, "Arquivo vazio: %s", filepath);
         }
+        file_reader_close(file);
+        delta_abandon(&delta);
+        TRACE_THREAD_END();
+        return;
+    }
 
-        bson_t telefones;
-        BSON_APPEND_ARRAY_BEGIN(&contatos, "telefones", &telefones);
-        int telefone_index = 0;
-        int telefones_count = json_object_array_length(telefones_array_obj);
-
-        for (int i = 0; i < telefones_count; i++) {
-            struct json_object* telefone_index_obj = json_object_array_get_idx(telefones_array_obj, i);
-            if (!telefone_index_obj) continue;
-
-            int telefone_field_index = json_object_get_int(telefone_index_obj) - 1;  // Ajusta para índice 0-based
-            if (telefone_field_index >= 0 && telefone_field_index < field_count && 
-                fields[telefone_field_index] && 
-                strlen(fields[telefone_field_index]) > 0 && 
-                strcmp(fields[telefone_field_index], " ") != 0 && 
-                strcmp(fields[telefone_field_index], "-") != 0) {
-                char key[8];
-                bson_snprintf(key, sizeof(key), "%d", telefone_index++);
-                BSON_APPEND_UTF8(&telefones, key, fields[telefone_field_index]);
-            }
+    // Resolve o cabeçalho antes de conectar: layouts incompatíveis são rejeitados aqui
+    FileWork work = {0};
+    size_t length = 0;
+    const char *header = transcode_line(data->encoding, line, (size_t)header_length, &work.transcoded, &length,
+        &work.invalid_sequences);
+    // O cabeçalho é resolvido como texto: um byte nulo esconderia as colunas seguintes
+    if (header && memchr(header, '\0', length)) {
+        logger_log(LOG_ERROR, "Arquivo %s rejeitado: cabeçalho contém byte nulo", job->filename);
+        header = NULL;
+    }
+    ColumnPlan *plan = header ? field_mapping_resolve(data->mapping, header, job->filename) : NULL;
+
+    // Linhas rejeitadas vão para rejects_dir/<arquivo>.rej
+    char reject_name[256];
+    snprintf(reject_name, sizeof(reject_name), "%.*s.rej", (int)(strlen(job->filename) - 4), job->filename);
+    if (!plan || !file_work_open(&work, data, job, plan, reject_name, !delta.enabled)) {
+        data->failed = true;
+        mongodb_client_close(work.client);
+        transcode_buffer_free(&work.transcoded);
+        column_plan_free(plan);
+        file_reader_close(file);
+        delta_abandon(&delta);
+        TRACE_THREAD_END();
+        return;
+    }
+    work.file = file;
+    work.delta = &delta;
+    work.counting_lines = true;
+    work.next_start = file_reader_tell(file);
+
+    // O modo incremental compara o arquivo inteiro com a importação anterior: sem roubo
+    file_job_publish(data->scheduler, job, plan, file_reader_tell(file), !delta.enabled);
+    if (job->data_start >= job->size) {
+        logger_log(LOG_ERROR, "Arquivo contém apenas cabeçalho: %s", filepath);
+    }
+
+    // Trechos consecutivos continuam no mesmo leitor, sem reposicionar
+    off_t start, end;
+    while (file_job_claim(data->scheduler, job, &start, &end)) {
+        file_reader_set_range(file, start, end);
+        process_lines(&work, start, end);
+    }
+    TRACE_THREAD_END();
+
+    file_reader_close(file);
+    if (work.read_failed) delta.incomplete = true;  // Chaves do arquivo ficaram desconhecidas
+
+    // O último lote de upserts é enviado aqui, para a quarentena receber as linhas se falhar
+    if (delta.enabled) {
+        bool flushed = mongodb_client_bulk_flush(work.client);
+        write_batch_bulk_result(&work.batch, work.client, -1, flushed);
+        if (!flushed) work.write_failed = true;
+    }
+    delta_finish(data, &delta, work.client, !work.write_failed);
+    file_work_finish(&work);
+    delta_free(&delta);
+
+    logger_log(LOG_INFO, "Arquivo %s: worker %d (dono) concluído, %d registros importados",
+        job->filename, data->worker_index, work.count);
+}
+
+// Worker ocioso: importa trechos roubados de um arquivo que outro worker
+// ainda processa. Retorna false se o worker não pode mais ajudar.
+static bool help_file(ThreadData *data, FileJob *job) {
+    char reject_name[256];
+    snprintf(reject_name, sizeof(reject_name), "%.*s_worker_%02d.rej",
+        (int)(strlen(job->filename) - 4), job->filename, data->worker_index);
+
+    // O cliente é criado antes de reservar o primeiro trecho, para nenhum trecho ficar sem dono
+    FileWork work = {0};
+    if (!file_work_open(&work, data, job, job->plan, reject_name, true)) {
+        mongodb_client_close(work.client);
+        return false;
+    }
+
+    off_t start, end;
+    if (!file_job_claim(data->scheduler, job, &start, &end)) {
+        file_work_finish(&work);
+        return true;
+    }
+
+    TRACE_THREAD_BEGIN(job->filename);
+    char filepath[256];
+    snprintf(filepath, sizeof(filepath), "files_csv/%s", job->filename);
+    FileReaderConfig reader_config = file_reader_config(data->config);
+    work.file = file_reader_open_range(filepath, &reader_config, start, end);
+    if (!work.file) {
+        logger_log(LOG_ERROR, "Erro ao abrir arquivo %s: trecho %lld-%lld não importado",
+            filepath, (long long)start, (long long)end);
+        data->failed = true;
+        TRACE_THREAD_END();
+        file_work_finish(&work);
+        return false;
+    }
+
+    int chunks = 0;
+    do {
+        file_reader_set_range(work.file, start, end);
+        process_lines(&work, start, end);
+        chunks++;
+    } while (file_job_claim(data->scheduler, job, &start, &end));
+    TRACE_THREAD_END();
+
+    file_reader_close(work.file);
+    file_work_finish(&work);
+    logger_log(LOG_INFO, "Arquivo %s: worker %d importou %d registros em %d trechos roubados",
+        job->filename, data->worker_index, work.count, chunks);
+    return true;
+}
+
+// Worker da importação de arquivos: primeiro os arquivos ainda sem dono, do
+// maior para o menor; depois, trechos dos arquivos que outros ainda processam
+void *import_worker(void *arg) {
+    ThreadData *data = (ThreadData*)arg;
+
+    // Posiciona a thread antes de qualquer alocação do worker
+    thread_placement_apply(data->worker_index);
+
+    FileJob *job;
+    while ((job = file_scheduler_next(data->scheduler)) != NULL) {
+        process_file(data, job);
+        // Se o dono desistiu antes de publicar, quem espera para roubar é liberado
+        file_job_abandon(data->scheduler, job);
+    }
+    while ((job = file_scheduler_steal(data->scheduler, &data->steal_wait_seconds)) != NULL) {
+        if (!help_file(data, job)) break;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &data->finished);
+    return NULL;
+}
+
+// Resolve o cabeçalho do fluxo uma única vez, no primeiro bloco recebido
+static const ColumnPlan* stream_input_plan(StreamInput *input, const FieldMapping *mapping,
+                                           InputEncoding encoding, TranscodeBuffer *transcoded) {
+    pthread_mutex_lock(&input->mutex);
+    if (!input->resolved) {
+        const char *name = stream_reader_name(input->reader);
+        const char *header = stream_reader_header(input->reader);
+        size_t length = 0;
+        long invalid = 0;
+        if (header) header = transcode_line(encoding, header, strlen(header), transcoded, &length, &invalid);
+        input->plan = header ? field_mapping_resolve(mapping, header, name) : NULL;
+        input->resolved = true;
+        if (!input->plan) {
+            logger_log(LOG_ERROR, "Fluxo %s rejeitado: o restante da entrada será descartado", name);
+            stream_reader_cancel(input->reader);
         }
-        bson_append_array_end(&contatos, &telefones);
+    }
+    pthread_mutex_unlock(&input->mutex);
+    return input->plan;
+}
 
-        // Adiciona emails
-        struct json_object* emails_array_obj;
-        if (!json_object_object_get_ex(contatos_obj, "emails", &emails_array_obj)) {
-            logger_log(LOG_ERROR, "Erro ao obter emails do mapeamento");
-            skipped_lines++;
-            bson_destroy(doc);
-            free_string_array(fields, field_count);
+// Worker do modo de fluxo: consome blocos de linhas de qualquer fluxo e insere em lotes
+// Bloco que o worker não consegue importar: todas as linhas vão para a
+// quarentena, para que nada suma sem registro. Retorna quantas linhas havia.
+static int reject_chunk(RejectWriter *rejects, const StreamInput *input, const StreamChunk *chunk, RejectReason reason) {
+    char source[288];
+    snprintf(source, sizeof(source), "%s#%ld", stream_reader_name(input->reader), chunk->sequence);
+
+    int chunk_line = 0;
+    const char *cursor = chunk->data;
+    const char *end = chunk->data + chunk->length;
+    while (cursor < end) {
+        const char *newline = memchr(cursor, '\n', (size_t)(end - cursor));
+        const char *line_end = newline ? newline : end;
+        reject_writer_add(rejects, source, ++chunk_line, reason, cursor, (size_t)(line_end - cursor));
+        cursor = line_end + 1;
+    }
+    return chunk_line;
+}
+
+void *process_stream(void *arg) {
+    StreamWorkerData *data = (StreamWorkerData*)arg;
+
+    thread_placement_apply(data->worker_index);
+    char trace_name[32];
+    snprintf(trace_name, sizeof(trace_name), "stream-%d", data->worker_index);
+    TRACE_THREAD_BEGIN(trace_name);
+
+    // Sem cliente o worker continua consumindo blocos, para não travar a
+    // leitura dos fluxos, e manda as linhas para a quarentena
+    MongoDBClient *client = open_client(data->config);
+    if (!client) {
+        logger_log(LOG_ERROR, "Erro ao inicializar cliente MongoDB no worker %d: os blocos que receber vão para a quarentena",
+            data->worker_index);
+        data->failed = true;
+    }
+    ShardedWriter *sharded = client ? open_sharded_writer(data->config, data->router) : NULL;
+
+    FieldSpan *fields = NULL;
+    int field_capacity = 0;
+    int count = 0;
+    int lines = 0;
+    int skipped_lines = 0;
+    TranscodeBuffer transcoded = {0};
+    long invalid_sequences = 0;
+    LoadDigest digests[MAX_STREAMS] = {0};  // Por fluxo
+
+    char reject_name[64];
+    snprintf(reject_name, sizeof(reject_name), "fluxo_worker_%02d.rej", data->worker_index);
+    RejectWriter *rejects = reject_writer_new(data->config->rejects_dir, reject_name);
+    WriteBatch batch = { pending_rows_new(), rejects, digests, 0 };
+    if (sharded) sharded_writer_on_done(sharded, write_batch_done, &batch);
+
+    StreamChunk *chunk;
+    while ((chunk = chunk_queue_pop(data->queue)) != NULL) {
+        StreamInput *input = &data->inputs[chunk->stream_index];
+        if (!client) {
+            int rejected = reject_chunk(rejects, input, chunk, REJECT_WRITE);
+            lines += rejected;
+            skipped_lines += rejected;
+            stream_chunk_free(chunk);
             continue;
         }
-
-        bson_t emails;
-        BSON_APPEND_ARRAY_BEGIN(&contatos, "emails", &emails);
-        int email_index = 0;
-        int emails_count = json_object_array_length(emails_array_obj);
-
-        for (int i = 0; i < emails_count; i++) {
-            struct json_object* email_index_obj = json_object_array_get_idx(emails_array_obj, i);
-            if (!email_index_obj) continue;
-
-            int email_field_index = json_object_get_int(email_index_obj) - 1;  // Ajusta para índice 0-based
-            if (email_field_index >= 0 && email_field_index < field_count && 
-                fields[email_field_index] && 
-                strlen(fields[email_field_index]) > 0 && 
-                strcmp(fields[email_field_index], " ") != 0 && 
-                strcmp(fields[email_field_index], "-") != 0) {
-                char key[8];
-                bson_snprintf(key, sizeof(key), "%d", email_index++);
-                BSON_APPEND_UTF8(&emails, key, fields[email_field_index]);
+        // Cabeçalho rejeitado: o fluxo já foi cancelado e conta como falha
+        const ColumnPlan *plan = stream_input_plan(input, data->mapping, data->encoding, &transcoded);
+        if (!plan) {
+            stream_chunk_free(chunk);
+            continue;
+        }
+        if (plan->max_column + 1 > field_capacity) {
+            FieldSpan *grown = realloc(fields, (plan->max_column + 1) * sizeof(FieldSpan));
+            if (!grown) {
+                logger_log(LOG_ERROR, "Worker %d: sem memória para as colunas, bloco %ld de %s na quarentena",
+                    data->worker_index, chunk->sequence, stream_reader_name(input->reader));
+                data->failed = true;
+                int rejected = reject_chunk(rejects, input, chunk, REJECT_MEMORY);
+                lines += rejected;
+                skipped_lines += rejected;
+                stream_chunk_free(chunk);
+                continue;
             }
+            fields = grown;
+            field_capacity = plan->max_column + 1;
         }
-        bson_append_array_end(&contatos, &emails);
 
-        bson_append_document_end(doc, &contatos);
+        // Nas rejeições, a linha é numerada dentro do bloco: <fluxo>#<bloco>
+        char source[288];
+        snprintf(source, sizeof(source), "%s#%ld", stream_reader_name(input->reader), chunk->sequence);
+
+        // O bloco tem só linhas completas e um byte livre após o fim
+        char *cursor = chunk->data;
+        char *end = chunk->data + chunk->length;
+        int chunk_line = 0;
+        while (cursor < end) {
+            char *newline = memchr(cursor, '\n', (size_t)(end - cursor));
+            char *line_end = newline ? newline : end;
+            *line_end = '\0';
+            char *line = cursor;
+            size_t raw_length = (size_t)(line_end - cursor);
+            size_t length = 0;
+            cursor = line_end + 1;
+            chunk_line++;
+            lines++;
+
+            TRACE_BEGIN(TRACE_DECODE);
+            const char *text = transcode_line(data->encoding, line, raw_length, &transcoded, &length, &invalid_sequences);
+            TRACE_END(TRACE_DECODE);
+            if (!text) {
+                reject_writer_add(rejects, source, chunk_line, REJECT_MEMORY, line, raw_length);
+                skipped_lines++;
+                continue;
+            }
 
-        if (!mongodb_client_insert(client, doc)) {
-            logger_log(LOG_ERROR, "Erro ao inserir documento na linha %d", file_lines);
-            skipped_lines++;
-        } else {
-            count++;
-            if (count % 1000 == 0) {
-                logger_log(LOG_INFO, "Arquivo %s: %d registros importados", data->filename, count);
+            int field_count = parse_row(plan, text, length, fields);
+            if (field_count < 0) {
+                reject_writer_add(rejects, source, chunk_line, REJECT_SPLIT, line, raw_length);
+                skipped_lines++;
+                continue;
             }
-        }
 
-        // Libera os campos
-        free_string_array(fields, field_count);
-        bson_destroy(doc);
+            bson_t *doc = bson_new();
+            if (!doc) {
+                reject_writer_add(rejects, source, chunk_line, REJECT_MEMORY, line, raw_length);
+                skipped_lines++;
+                continue;
+            }
+            TRACE_BEGIN(TRACE_BUILD);
+            build_document(data->mapping, plan, fields, field_count, doc);
+            TRACE_END(TRACE_BUILD);
+
+            // A linha fica guardada até o servidor confirmar o lote; recusas são descontadas ao final
+            DigestRow digest = row_digest(plan, fields, field_count);
+            int tag = write_batch_add(&batch, source, chunk_line, line, raw_length, chunk->stream_index, &digest);
+            if (tag < 0) {
+                skipped_lines++;
+            } else if (sharded) {
+                sharded_writer_insert(sharded, doc, tag);
+            } else {
+                bool written = mongodb_client_bulk_insert(client, doc);
+                write_batch_bulk_result(&batch, client, tag, written);
+            }
+            if (tag >= 0 && ++count % PROGRESS_INTERVAL == 0) {
+                logger_log(LOG_INFO, "Worker %d: %d registros importados", data->worker_index, count);
+            }
+            bson_destroy(doc);
+            TRACE_ROW_END();
+        }
+        stream_chunk_free(chunk);
     }
+    TRACE_THREAD_END();
 
-    free(line);
-    fclose(file);
+    // Envia o que sobrou nos lotes
+    if (sharded) {
+        if (!sharded_writer_flush(sharded)) {
+            logger_log(LOG_ERROR, "Worker %d: falha ao enviar lotes aos shards", data->worker_index);
+        }
+        count = (int)sharded_writer_written(sharded);
+        sharded_writer_free(sharded);
+    } else if (client) {
+        bool flushed = mongodb_client_bulk_flush(client);
+        write_batch_bulk_result(&batch, client, -1, flushed);
+        if (!flushed) logger_log(LOG_ERROR, "Worker %d: falha ao enviar o último lote", data->worker_index);
+        count -= batch.rejected;
+    }
+    skipped_lines += batch.rejected;
+    if (batch.rejected > 0) data->failed = true;
 
-    // Atualiza os totais globais
     pthread_mutex_lock(&count_mutex);
-    total_lines_read += file_lines;
+    total_lines_read += lines;
     total_documents_inserted += count;
+    total_invalid_sequences += invalid_sequences;
+    for (int i = 0; i < data->input_count; i++) {
+        load_digest_merge(&total_digest, &digests[i]);
+        record_source_digest(stream_reader_name(data->inputs[i].reader), &digests[i]);
+    }
     pthread_mutex_unlock(&count_mutex);
 
-    // Limpa
     mongodb_client_close(client);
-    json_object_put(mapping);
+    transcode_buffer_free(&transcoded);
+    pending_rows_free(batch.rows);
+    reject_writer_close(rejects);
+    free(fields);
+    logger_log(LOG_INFO, "Worker %d concluído: %d registros importados, %d linhas ignoradas",
+        data->worker_index, count, skipped_lines);
+    return NULL;
+}
+
+// Importa os arquivos pagina_NNNN.csv de files_csv com max_threads workers
+static bool import_files(Config *config, const FieldMapping *mapping, ImportManifest *manifest,
+                         ShardRouter *router, int key_field, InputEncoding encoding) {
+    // Lista os arquivos com o tamanho de cada um, do maior para o menor
+    off_t chunk_size = (off_t)config->steal_chunk_mb * 1024 * 1024;
+    FileScheduler *scheduler = file_scheduler_new("files_csv", is_valid_filename, manifest ? 0 : chunk_size);
+    if (!scheduler) {
+        return false;
+    }
+    if (scheduler->job_count == 0) {
+        logger_log(LOG_WARNING, "Nenhum arquivo pagina_NNNN.csv em files_csv");
+        file_scheduler_free(scheduler);
+        return true;
+    }
+
+    // Sem roubo de trechos, workers além do número de arquivos ficariam parados
+    int worker_count = config->max_threads;
+    if (worker_count < 1) worker_count = 1;
+    if (worker_count > MAX_THREADS) worker_count = MAX_THREADS;
+    if (scheduler->chunk_size == 0 && worker_count > scheduler->job_count) worker_count = scheduler->job_count;
+    logger_log(LOG_INFO, "Importando %d arquivos com %d workers; maior: %s (%lld bytes)",
+        scheduler->job_count, worker_count, scheduler->jobs[0].filename, (long long)scheduler->jobs[0].size);
 
-    logger_log(LOG_INFO, "Arquivo %s concluído: %d registros importados", data->filename, count);
+    // Cria os workers
+    pthread_t threads[MAX_THREADS];
+    ThreadData thread_data[MAX_THREADS];
+
+    for (int i = 0; i < worker_count; i++) {
+        memset(&thread_data[i], 0, sizeof(ThreadData));
+        thread_data[i].config = config;
+        thread_data[i].mapping = mapping;
+        thread_data[i].manifest = manifest;
+        thread_data[i].router = router;
+        thread_data[i].key_field = key_field;
+        thread_data[i].encoding = encoding;
+        thread_data[i].scheduler = scheduler;
+        thread_data[i].worker_index = i;
+        int rc = pthread_create(&threads[i], NULL, import_worker, &thread_data[i]);
+        if (rc != 0) {
+            // Os arquivos são pedidos ao escalonador: os workers já criados importam todos
+            logger_log(LOG_ERROR, "Erro ao criar o worker %d: %s; seguindo com %d", i, strerror(rc), i);
+            worker_count = i;
+            break;
+        }
+    }
+    if (worker_count == 0) {
+        file_scheduler_free(scheduler);
+        return false;
+    }
+
+    // Aguarda os workers terminarem
+    bool ok = true;
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(threads[i], NULL);
+        if (thread_data[i].failed) ok = false;
+    }
+
+    // Remoções incrementais só depois que todos os arquivos enviaram seus upserts
+    if (manifest && !delta_commit(config, manifest)) ok = false;
+
+    // Tempo ocioso: do fim de cada worker até o fim do último, mais a espera
+    // por arquivos entregues a outros workers e ainda sem cabeçalho publicado
+    double finished[MAX_THREADS];
+    double last_finished = 0;
+    for (int i = 0; i < worker_count; i++) {
+        finished[i] = (double)thread_data[i].finished.tv_sec + (double)thread_data[i].finished.tv_nsec / 1e9;
+        if (finished[i] > last_finished) last_finished = finished[i];
+    }
+    for (int i = 0; i < worker_count; i++) {
+        worker_tail_seconds[i] = last_finished - finished[i];
+        worker_wait_seconds[i] = thread_data[i].steal_wait_seconds;
+    }
+    import_worker_count = worker_count;
+
+    file_scheduler_free(scheduler);
+    return ok;
+}
+
+// Importa fluxos (stdin ou pipes nomeados): uma thread de leitura por fluxo
+// divide a entrada em blocos de linhas completas, consumidos por max_threads workers
+static bool import_streams(Config *config, const FieldMapping *mapping, ShardRouter *router,
+                           char **paths, int stream_count, InputEncoding encoding) {
+    int worker_count = config->max_threads;
+    if (worker_count < 1) worker_count = 1;
+    if (worker_count > MAX_THREADS) worker_count = MAX_THREADS;
+
+    ChunkQueue *queue = chunk_queue_new(config->stream_queue_chunks, stream_count);
+    StreamInput *inputs = calloc((size_t)stream_count, sizeof(StreamInput));
+    if (!queue || !inputs) {
+        logger_log(LOG_ERROR, "Erro ao alocar a fila de blocos dos fluxos");
+        chunk_queue_free(queue);
+        free(inputs);
+        return false;
+    }
+
+    size_t buffer_size = (size_t)config->stream_buffer_mb * 1024 * 1024;
+    for (int i = 0; i < stream_count; i++) {
+        pthread_mutex_init(&inputs[i].mutex, NULL);
+        inputs[i].reader = stream_reader_new(paths[i], i, buffer_size);
+        // Um leitor que não inicia conta como fluxo encerrado
+        if (!inputs[i].reader || !stream_reader_start(inputs[i].reader, queue)) {
+            logger_log(LOG_ERROR, "Erro ao iniciar leitura do fluxo %s", paths[i]);
+            chunk_queue_producer_done(queue);
+        }
+    }
+    logger_log(LOG_INFO, "Lendo %d fluxo(s) com %d workers", stream_count, worker_count);
+
+    pthread_t threads[MAX_THREADS];
+    StreamWorkerData worker_data[MAX_THREADS];
+    for (int i = 0; i < worker_count; i++) {
+        worker_data[i].config = config;
+        worker_data[i].mapping = mapping;
+        worker_data[i].router = router;
+        worker_data[i].inputs = inputs;
+        worker_data[i].input_count = stream_count;
+        worker_data[i].queue = queue;
+        worker_data[i].encoding = encoding;
+        worker_data[i].worker_index = i;
+        worker_data[i].failed = false;
+        int rc = pthread_create(&threads[i], NULL, process_stream, &worker_data[i]);
+        if (rc != 0) {
+            logger_log(LOG_ERROR, "Erro ao criar o worker %d: %s; seguindo com %d", i, strerror(rc), i);
+            worker_count = i;
+            break;
+        }
+    }
+
+    // Sem workers, os leitores são cancelados e a fila é esvaziada aqui,
+    // para que nenhum fique preso esperando espaço
+    bool ok = worker_count > 0;
+    if (worker_count == 0) {
+        for (int i = 0; i < stream_count; i++) stream_reader_cancel(inputs[i].reader);
+        StreamChunk *chunk;
+        while ((chunk = chunk_queue_pop(queue)) != NULL) stream_chunk_free(chunk);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        if (worker_data[i].failed) ok = false;
+    }
+    for (int i = 0; i < stream_count; i++) {
+        if (inputs[i].reader && !stream_reader_finish(inputs[i].reader)) ok = false;
+        if (inputs[i].resolved && !inputs[i].plan) ok = false;
+        stream_reader_free(inputs[i].reader);
+        column_plan_free(inputs[i].plan);
+        pthread_mutex_destroy(&inputs[i].mutex);
+    }
+    free(inputs);
+    chunk_queue_free(queue);
+    if (!ok) logger_log(LOG_ERROR, "Um ou mais fluxos não foram importados por completo");
+    return ok;
+}
+
+// Aplica os limites globais de escrita (e a agenda) da configuração
+static void apply_rate_limits(const Config *config) {
+    RateLimitConfig limits = {
+        .docs_per_sec = config->rate_docs_per_sec,
+        .bytes_per_sec = config->rate_bytes_per_sec,
+        .windows = config->rate_schedule,
+        .window_count = config->rate_schedule_count
+    };
+    rate_limiter_configure(&limits);
+}
+
+static bool signal_thread_stop = false;
+
+// Thread de sinais: SIGHUP relê os limites de escrita de config.json durante a importação
+static void *signal_thread(void *arg) {
+    const sigset_t *signals = (const sigset_t*)arg;
+    for (;;) {
+        int signal_number;
+        if (sigwait(signals, &signal_number) != 0) continue;
+        if (__atomic_load_n(&signal_thread_stop, __ATOMIC_ACQUIRE)) break;
+
+        Config *reloaded = load_config(CONFIG_PATH);
+        if (!reloaded) {
+            logger_log(LOG_ERROR, "SIGHUP: erro ao recarregar %s, limites de escrita mantidos", CONFIG_PATH);
+            continue;
+        }
+        apply_rate_limits(reloaded);
+        logger_log(LOG_INFO, "SIGHUP: limites de escrita recarregados (%ld docs/s, %ld bytes/s, %d janelas)",
+            reloaded->rate_docs_per_sec, reloaded->rate_bytes_per_sec, reloaded->rate_schedule_count);
+        free_config(reloaded);
+    }
     return NULL;
 }
 
-int main() {
+// Lê as opções da linha de comando: --stdin e --pipe <caminho> (repetível)
+static bool parse_arguments(int argc, char *argv[], char **stream_paths, int *stream_count) {
+    *stream_count = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *path = NULL;
+        if (strcmp(argv[i], "--stdin") == 0) {
+            path = "-";
+        } else if (strcmp(argv[i], "--pipe") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            fprintf(stderr, "Uso: %s [--stdin] [--pipe <caminho>]...\n", argv[0]);
+            return false;
+        }
+        if (*stream_count == MAX_STREAMS) {
+            fprintf(stderr, "Máximo de %d fluxos\n", MAX_STREAMS);
+            return false;
+        }
+        stream_paths[(*stream_count)++] = (char*)path;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    char *stream_paths[MAX_STREAMS];
+    int stream_count = 0;
+    if (!parse_arguments(argc, argv, stream_paths, &stream_count)) {
+        return 1;
+    }
+
+    // SIGHUP fica bloqueado em todas as threads e é tratado só pela thread de sinais
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
     // Inicializa o logger
     logger_init();
     logger_log(LOG_INFO, "Iniciando importação de arquivos CSV");
@@ -517,55 +1467,134 @@ int main() {
     time_t start_time = time(NULL);
 
     // Carrega as configurações
-    Config *config = load_config("config/config.json");
+    Config *config = load_config(CONFIG_PATH);
     if (!config) {
         logger_log(LOG_ERROR, "Erro ao carregar configurações");
         return 1;
     }
 
-    // Lista os arquivos do diretório
-    DIR *dir = opendir("files_csv");
-    if (!dir) {
-        logger_log(LOG_ERROR, "Erro ao abrir diretório files_csv");
+    // Codificação dos arquivos de entrada; tudo é convertido para UTF-8
+    InputEncoding encoding;
+    if (!encoding_parse(config->input_encoding, &encoding)) {
+        logger_log(LOG_ERROR, "Codificação de entrada desconhecida: %s", config->input_encoding);
+        free_config(config);
         return 1;
     }
 
-    // Array para armazenar os nomes dos arquivos
-    char **csv_files = NULL;
-    int file_count = 0;
-    struct dirent *entry;
-
-    // Lê os arquivos do diretório
-    while ((entry = readdir(dir)) != NULL) {
-        if (is_valid_filename(entry->d_name)) {
-            csv_files = realloc(csv_files, (file_count + 1) * sizeof(char*));
-            csv_files[file_count] = strdup(entry->d_name);
-            file_count++;
-        }
+    // Fluxos não têm nome/tamanho estáveis para o manifesto incremental
+    if (stream_count > 0 && config->incremental) {
+        logger_log(LOG_WARNING, "Modo incremental ignorado na leitura de fluxos");
+        config->incremental = false;
     }
-    closedir(dir);
 
-    // Ordena os arquivos por nome
-    qsort(csv_files, file_count, sizeof(char*), compare_files);
+    // Define o posicionamento das threads (CPU/NUMA)
+    ThreadPlacementConfig placement = {
+        .pin_threads = config->thread_pinning,
+        .numa_local_memory = config->numa_local_memory,
+        .numa_spread = config->numa_spread
+    };
+    thread_placement_init(&placement);
+    TRACE_INIT(PROGRESS_INTERVAL, config->trace_window_start, config->trace_window_batches);
+
+    // Compila o mapeamento de campos uma única vez, validado contra fields.txt
+    int whitelist_count = 0;
+    char **whitelist = read_fields_from_file("fields.txt", &whitelist_count);
+    if (!whitelist) {
+        logger_log(LOG_WARNING, "fields.txt não encontrado: colunas do cabeçalho não serão validadas");
+    }
+    FieldMapping *mapping = field_mapping_load("config/field_mapping.json", whitelist, whitelist_count);
+    free_string_array(whitelist, whitelist_count);
+    if (!mapping) {
+        logger_log(LOG_ERROR, "Erro ao carregar mapeamento de campos");
+        free_config(config);
+        return 1;
+    }
 
-    // Ajusta o número máximo de threads para o número de arquivos
-    config->max_threads = file_count;
+    // Modo incremental: manifesto e fingerprints ficam em state_dir
+    ImportManifest *manifest = NULL;
+    int key_field = -1;
+    if (config->incremental) {
+        for (int i = 0; i < mapping->field_count; i++) {
+            if (strcmp(mapping->fields[i].name, INCREMENTAL_KEY_FIELD) == 0) key_field = i;
+        }
+        if (key_field < 0) {
+            logger_log(LOG_ERROR, "Modo incremental requer o campo %s no mapeamento", INCREMENTAL_KEY_FIELD);
+            field_mapping_free(mapping);
+            free_config(config);
+            return 1;
+        }
+        if (mkdir(config->state_dir, 0755) != 0 && errno != EEXIST) {
+            logger_log(LOG_ERROR, "Erro ao criar diretório de estado: %s", config->state_dir);
+            field_mapping_free(mapping);
+            free_config(config);
+            return 1;
+        }
+        char manifest_path[512];
+        snprintf(manifest_path, sizeof(manifest_path), "%s/manifest.tsv", config->state_dir);
+        manifest = manifest_load(manifest_path);
+    }
 
-    // Cria as threads
-    pthread_t threads[MAX_THREADS];
-    ThreadData thread_data[MAX_THREADS];
+    // Verificação pós-carga: digests por faixa da chave, comparados com a coleção
+    if (config->verify && config->incremental) {
+        logger_log(LOG_WARNING, "Verificação ignorada no modo incremental: a coleção também contém as linhas inalteradas");
+    } else if (config->verify) {
+        for (int i = 0; i < mapping->field_count; i++) {
+            if (strcmp(mapping->fields[i].name, VERIFY_KEY_FIELD) == 0) verify_key_field = i;
+            if (strcmp(mapping->fields[i].name, VERIFY_LENGTH_FIELD) == 0) verify_length_field = i;
+        }
+        if (verify_key_field < 0) {
+            logger_log(LOG_WARNING, "Verificação requer o campo %s no mapeamento: desativada", VERIFY_KEY_FIELD);
+        }
+    }
 
-    for (int i = 0; i < file_count; i++) {
-        thread_data[i].filename = csv_files[i];
-        thread_data[i].config = config;
-        pthread_create(&threads[i], NULL, process_file, &thread_data[i]);
+    // Os digests só descrevem a coleção se ela começar vazia
+    if (verify_key_field >= 0) {
+        char uri[512];
+        config_uri(config, uri, sizeof(uri));
+        int64_t existing = collection_count(uri, config->mongodb_database, config->mongodb_collection);
+        if (existing != 0) {
+            if (existing > 0) {
+                logger_log(LOG_WARNING, "Verificação desativada: a coleção já tem %lld documentos antes da carga",
+                    (long long)existing);
+            } else {
+                logger_log(LOG_WARNING, "Verificação desativada: não foi possível contar os documentos da coleção");
+            }
+            printf("Verificação desativada: a coleção %s não está vazia ou não pôde ser consultada\n",
+                config->mongodb_collection);
+            verify_key_field = -1;
+            verify_length_field = -1;
+        }
     }
 
-    // Aguarda as threads terminarem
-    for (int i = 0; i < file_count; i++) {
-        pthread_join(threads[i], NULL);
+    // Roteamento por shard: metadados lidos uma vez do config database via mongos
+    ShardRouter *router = NULL;
+    if (config->shard_routing) {
+        char hosts[256];
+        char uri[512];
+        snprintf(hosts, sizeof(hosts), "%s:%d", config->mongodb_host, config->mongodb_port);
+        mongodb_build_uri(uri, sizeof(uri), hosts, config->mongodb_username, config->mongodb_password, NULL);
+        router = shard_router_load(uri, config->mongodb_database, config->mongodb_collection);
+        if (!router) {
+            logger_log(LOG_WARNING, "Roteamento por shard desativado: inserções seguem pelo mongos");
+        } else if (config->shard_direct_connections) {
+            logger_log(LOG_WARNING, "Conexões diretas aos shards: desative o balancer durante a carga para evitar documentos órfãos");
+        }
     }
 
+    // Limites de escrita; podem ser alterados durante a carga com SIGHUP
+    apply_rate_limits(config);
+    pthread_t signal_handler;
+    bool signal_handler_started = pthread_create(&signal_handler, NULL, signal_thread, &signals) == 0;
+
+    // Importa os fluxos informados na linha de comando ou os arquivos de files_csv
+    bool imported = stream_count > 0
+        ? import_streams(config, mapping, router, stream_paths, stream_count, encoding)
+        : import_files(config, mapping, manifest, router, key_field, encoding);
+    if (signal_handler_started) {
+        __atomic_store_n(&signal_thread_stop, true, __ATOMIC_RELEASE);
+        pthread_kill(signal_handler, SIGHUP);
+        pthread_join(signal_handler, NULL);
+    }
     // Mostra estatísticas finais
     time_t end_time = time(NULL);
     double execution_time = difftime(end_time, start_time);
@@ -573,16 +1602,75 @@ int main() {
     printf("\nEstatísticas finais:\n");
     printf("Total de linhas lidas: %d\n", total_lines_read);
     printf("Total de documentos inseridos: %d\n", total_documents_inserted);
+    if (manifest) {
+        printf("Total de documentos atualizados: %d\n", total_documents_updated);
+        printf("Total de documentos removidos: %d\n", total_documents_deleted);
+        printf("Arquivos inalterados ignorados: %d\n", total_files_unchanged);
+    }
+    if (encoding != INPUT_ENCODING_UTF8 || total_invalid_sequences > 0) {
+        printf("Sequências inválidas em %s: %ld\n", encoding_name(encoding), total_invalid_sequences);
+    }
+    for (int reason = 0; reason < REJECT_REASON_COUNT; reason++) {
+        long rejected = reject_count((RejectReason)reason);
+        if (rejected > 0) {
+            printf("Linhas rejeitadas (%s): %ld\n", reject_reason_code((RejectReason)reason), rejected);
+            logger_log(LOG_WARNING, "Linhas rejeitadas (%s): %ld, gravadas em %s/",
+                reject_reason_code((RejectReason)reason), rejected, config->rejects_dir);
+        }
+    }
+    if (import_worker_count > 0) {
+        printf("Tempo ocioso por worker (esperando cabeçalhos + até o fim do último):\n");
+        for (int i = 0; i < import_worker_count; i++) {
+            printf("  Worker %d: %.2f segundos (%.2f + %.2f)\n", i,
+                worker_wait_seconds[i] + worker_tail_seconds[i], worker_wait_seconds[i], worker_tail_seconds[i]);
+        }
+    }
+    if (rate_limiter_active() || rate_limiter_throttled_seconds() > 0) {
+        printf("Tempo em espera pelo limite de escrita: %.2f segundos (soma das threads)\n",
+            rate_limiter_throttled_seconds());
+    }
     printf("Tempo de execução: %.2f segundos\n", execution_time);
 
-    // Limpa
-    for (int i = 0; i < file_count; i++) {
-        free(csv_files[i]);
+    // Importação incompleta (ex.: erro de leitura ou cabeçalho rejeitado em um
+    // fluxo): as estatísticas acima valem, mas o processo termina com erro.
+    // Completa, recalcula os digests no servidor, uma agregação por faixa em paralelo
+    int exit_code = 0;
+    if (!imported) {
+        printf("Importação incompleta, veja o log\n");
+        exit_code = 1;
+    } else if (verify_key_field >= 0) {
+        char uri[512];
+        config_uri(config, uri, sizeof(uri));
+        int mismatches = collection_verify(uri, config->mongodb_database, config->mongodb_collection,
+            VERIFY_KEY_FIELD, VERIFY_LENGTH_FIELD, &total_digest, source_digests, source_digest_count);
+        if (mismatches == 0) {
+            printf("Verificação: a coleção confere com a importação\n");
+        } else if (mismatches > 0) {
+            printf("Verificação: %d faixa(s) de %s divergente(s)\n", mismatches, VERIFY_KEY_FIELD);
+            exit_code = 1;
+        } else {
+            printf("Verificação não concluída, veja o log\n");
+            exit_code = 1;
+        }
     }
-    free(csv_files);
+
+    TRACE_DUMP(config->trace_file);
+
+    if (manifest) {
+        manifest_save(manifest);
+        manifest_free(manifest);
+    }
+    shard_router_free(router);
+    for (int i = 0; i < source_digest_count; i++) free(source_digests[i].source);
+    free(source_digests);
+
+    // Limpa
+    field_mapping_free(mapping);
     free_config(config);
+    rate_limiter_cleanup();
+    thread_placement_cleanup();
     logger_log(LOG_INFO, "Importação concluída em %.2f segundos", execution_time);
     logger_close();
 
-    return 0;
+    return exit_code;
 } 
\ No newline at end of file
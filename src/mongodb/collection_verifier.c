@@ -0,0 +1,161 @@
+#include "collection_verifier.h"
+#include "mongodb_client.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+    const char *uri;
+    const char *database;
+    const char *collection;
+    const char *key_field;
+    const char *length_field;
+    int range;
+    DigestRange result;
+    bool ok;
+} RangeQuery;
+
+// Filtro da faixa: prefixo de um dígito, ou tudo fora de ["0", ":")
+static void range_match(char *match, size_t size, const char *key_field, int range) {
+    if (range == DIGEST_OTHER_RANGE) {
+        snprintf(match, size, "{\"%s\": {\"$not\": {\"$gte\": \"0\", \"$lt\": \":\"}}}", key_field);
+    } else {
+        snprintf(match, size, "{\"%s\": {\"$gte\": \"%c\", \"$lt\": \"%c\"}}",
+            key_field, '0' + range, '0' + range + 1);
+    }
+}
+
+// Mesmo cálculo de load_digest_add, feito pelo servidor só sobre a faixa.
+// Com índice na chave, o $match percorre apenas o trecho do índice da faixa.
+static void* query_range(void *arg) {
+    RangeQuery *query = (RangeQuery*)arg;
+
+    char match[256];
+    range_match(match, sizeof(match), query->key_field, query->range);
+
+    char pipeline_json[2048];
+    snprintf(pipeline_json, sizeof(pipeline_json),
+        "{\"pipeline\": ["
+        "{\"$match\": %s},"
+        "{\"$group\": {\"_id\": null,"
+        " \"count\": {\"$sum\": 1},"
+        " \"key_sum\": {\"$sum\": {\"$mod\": [{\"$convert\": {"
+        "   \"input\": {\"$replaceAll\": {\"input\": {\"$replaceAll\": {\"input\": \"$%s\", \"find\": \".\", \"replacement\": \"\"}},"
+        "                               \"find\": \"-\", \"replacement\": \"\"}},"
+        "   \"to\": \"long\", \"onError\": {\"$numberLong\": \"0\"}, \"onNull\": {\"$numberLong\": \"0\"}}},"
+        "   {\"$numberLong\": \"%lld\"}]}},"
+        " \"length_sum\": {\"$sum\": {\"$strLenCP\": {\"$ifNull\": [\"$%s\", \"\"]}}}}}"
+        "]}",
+        match, query->key_field, (long long)DIGEST_KEY_MODULUS, query->length_field);
+
+    bson_error_t error;
+    bson_t *pipeline = bson_new_from_json((const uint8_t*)pipeline_json, -1, &error);
+    if (!pipeline) {
+        logger_log(LOG_ERROR, "Verificação: pipeline inválido: %s", error.message);
+        return NULL;
+    }
+
+    MongoDBClient *client = mongodb_client_init(query->uri, query->database, query->collection);
+    if (!client) {
+        bson_destroy(pipeline);
+        return NULL;
+    }
+
+    mongoc_cursor_t *cursor = mongoc_collection_aggregate(client->collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+    const bson_t *doc;
+    // Faixa sem documentos não gera resultado: o digest fica zerado
+    if (mongoc_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        if (bson_iter_init_find(&it, doc, "count")) query->result.count = bson_iter_as_int64(&it);
+        if (bson_iter_init_find(&it, doc, "key_sum")) query->result.key_sum = bson_iter_as_int64(&it);
+        if (bson_iter_init_find(&it, doc, "length_sum")) query->result.length_sum = bson_iter_as_int64(&it);
+    }
+    query->ok = !mongoc_cursor_error(cursor, &error);
+    if (!query->ok) {
+        logger_log(LOG_ERROR, "Verificação da faixa %d falhou: %s", query->range, error.message);
+    }
+
+    mongoc_cursor_destroy(cursor);
+    mongodb_client_close(client);
+    bson_destroy(pipeline);
+    return NULL;
+}
+
+static void range_label(char *label, size_t size, int range) {
+    if (range == DIGEST_OTHER_RANGE) {
+        snprintf(label, size, "outras");
+    } else {
+        snprintf(label, size, "%c*", '0' + range);
+    }
+}
+
+int64_t collection_count(const char *uri, const char *database, const char *collection) {
+    MongoDBClient *client = mongodb_client_init(uri, database, collection);
+    if (!client) return -1;
+
+    bson_t filter;
+    bson_init(&filter);
+    bson_error_t error;
+    int64_t count = mongoc_collection_count_documents(client->collection, &filter, NULL, NULL, NULL, &error);
+    if (count < 0) {
+        logger_log(LOG_ERROR, "Erro ao contar documentos de %s.%s: %s", database, collection, error.message);
+    }
+    bson_destroy(&filter);
+    mongodb_client_close(client);
+    return count;
+}
+
+int collection_verify(const char *uri, const char *database, const char *collection,
+                      const char *key_field, const char *length_field, const LoadDigest *expected,
+                      const SourceDigest *sources, int source_count) {
+    RangeQuery queries[DIGEST_RANGE_COUNT];
+    pthread_t threads[DIGEST_RANGE_COUNT];
+    bool started[DIGEST_RANGE_COUNT];
+
+    for (int i = 0; i < DIGEST_RANGE_COUNT; i++) {
+        memset(&queries[i], 0, sizeof(RangeQuery));
+        queries[i].uri = uri;
+        queries[i].database = database;
+        queries[i].collection = collection;
+        queries[i].key_field = key_field;
+        queries[i].length_field = length_field;
+        queries[i].range = i;
+        started[i] = pthread_create(&threads[i], NULL, query_range, &queries[i]) == 0;
+    }
+
+    int mismatches = 0;
+    bool failed = false;
+    for (int i = 0; i < DIGEST_RANGE_COUNT; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+        if (!started[i] || !queries[i].ok) {
+            failed = true;
+            continue;
+        }
+
+        const DigestRange *local = &expected->ranges[i];
+        const DigestRange *server = &queries[i].result;
+        if (local->count == server->count && local->key_sum == server->key_sum &&
+            local->length_sum == server->length_sum) {
+            continue;
+        }
+
+        char label[16];
+        range_label(label, sizeof(label), i);
+        mismatches++;
+        logger_log(LOG_ERROR, "Verificação: faixa %s %s diverge (importados %lld/%lld/%lld, coleção %lld/%lld/%lld)",
+            key_field, label,
+            (long long)local->count, (long long)local->key_sum, (long long)local->length_sum,
+            (long long)server->count, (long long)server->key_sum, (long long)server->length_sum);
+        printf("Faixa %s %s: importados %lld documentos, coleção %lld (digests %s)\n",
+            key_field, label, (long long)local->count, (long long)server->count,
+            local->key_sum == server->key_sum && local->length_sum == server->length_sum ? "iguais" : "diferentes");
+        for (int s = 0; s < source_count; s++) {
+            int64_t count = sources[s].digest.ranges[i].count;
+            if (count > 0) printf("  %s: %lld documentos importados nesta faixa\n", sources[s].source, (long long)count);
+        }
+    }
+
+    return failed ? -1 : mismatches;
+}
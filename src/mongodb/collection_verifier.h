@@ -0,0 +1,18 @@
+#ifndef COLLECTION_VERIFIER_H
+#define COLLECTION_VERIFIER_H
+
+#include <stdint.h>
+#include "../data/load_digest.h"
+
+// Quantidade de documentos na coleção; -1 se a contagem falhou
+int64_t collection_count(const char *uri, const char *database, const char *collection);
+
+// Recalcula no servidor, uma agregação por faixa da chave em paralelo, o
+// digest dos documentos da coleção e compara com o digest da importação.
+// Em cada faixa divergente, lista quantos documentos de cada origem caíram nela.
+// Retorna a quantidade de faixas divergentes, ou -1 se a verificação falhou.
+int collection_verify(const char *uri, const char *database, const char *collection,
+                      const char *key_field, const char *length_field, const LoadDigest *expected,
+                      const SourceDigest *sources, int source_count);
+
+#endif // COLLECTION_VERIFIER_H
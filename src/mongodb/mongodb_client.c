@@ -1,19 +1,51 @@
 #include "mongodb_client.h"
+#include "rate_limiter.h"
+#include "../utils/trace.h"
+#include "../utils/logger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define DEFAULT_BATCH_SIZE 1000
+
 static int total_documents = 0;
+static long write_errors = 0;   // Atualizado sem lock pelos workers
+
+static bool is_power_of_ten(long value) {
+    while (value >= 10 && value % 10 == 0) value /= 10;
+    return value == 1;
+}
+
+void mongodb_client_log_write_error(const char *operation, const char *message) {
+    long total = __atomic_add_fetch(&write_errors, 1, __ATOMIC_RELAXED);
+    if (is_power_of_ten(total)) {
+        logger_log(LOG_ERROR, "%s: %s; %ld falhas de escrita até agora", operation, message, total);
+    }
+}
+
+void mongodb_build_uri(char *uri, size_t size, const char *hosts, const char *username,
+                       const char *password, const char *options) {
+    bool has_options = options && options[0];
+    if (username && username[0]) {
+        snprintf(uri, size, "mongodb://%s:%s@%s/%s%s", username, password ? password : "", hosts,
+            has_options ? "?" : "", has_options ? options : "");
+    } else {
+        snprintf(uri, size, "mongodb://%s/%s%s", hosts, has_options ? "?" : "", has_options ? options : "");
+    }
+}
 
 MongoDBClient* mongodb_client_init(const char *uri, const char *database, const char *collection) {
-    MongoDBClient *client = (MongoDBClient*)malloc(sizeof(MongoDBClient));
+    MongoDBClient *client = (MongoDBClient*)calloc(1, sizeof(MongoDBClient));
     if (!client) return NULL;
+    client->bulk_size = DEFAULT_BATCH_SIZE;
 
     // Inicializa o driver MongoDB
     mongoc_init();
 
     // Cria o cliente
+    TRACE_BEGIN(TRACE_CONNECT);
     client->client = mongoc_client_new(uri);
+    TRACE_END(TRACE_CONNECT);
     if (!client->client) {
         fprintf(stderr, "Erro ao criar cliente MongoDB\n");
         free(client);
@@ -42,6 +74,11 @@ MongoDBClient* mongodb_client_init(const char *uri, const char *database, const
 
 void mongodb_client_close(MongoDBClient *client) {
     if (client) {
+        if (client->bulk_pending > 0) {
+            fprintf(stderr, "Aviso: enviando %d operações pendentes ao fechar o cliente\n", client->bulk_pending);
+            mongodb_client_bulk_flush(client);
+        }
+        if (client->bulk) mongoc_bulk_operation_destroy(client->bulk);
         if (client->collection) mongoc_collection_destroy(client->collection);
         if (client->database) mongoc_database_destroy(client->database);
         if (client->client) mongoc_client_destroy(client->client);
@@ -53,9 +90,12 @@ bool mongodb_client_insert(MongoDBClient *client, bson_t *doc) {
     if (!client || !client->collection || !doc) return false;
 
     bson_error_t error;
+    rate_limiter_acquire(1, doc->len);
+    TRACE_BEGIN(TRACE_INSERT);
     bool result = mongoc_collection_insert_one(client->collection, doc, NULL, NULL, &error);
+    TRACE_END(TRACE_INSERT);
     if (!result) {
-        fprintf(stderr, "Erro ao inserir documento: %s\n", error.message);
+        mongodb_client_log_write_error("Erro ao inserir documento", error.message);
     } else {
         total_documents++;
     }
@@ -72,7 +112,7 @@ bool mongodb_client_insert_to_collection(MongoDBClient *client, const char *coll
     bson_error_t error;
     bool result = mongoc_collection_insert_one(collection, doc, NULL, NULL, &error);
     if (!result) {
-        fprintf(stderr, "Erro ao inserir documento na coleção %s: %s\n", collection_name, error.message);
+        mongodb_client_log_write_error(collection_name, error.message);
     }
 
     mongoc_collection_destroy(collection);
@@ -81,4 +121,92 @@ bool mongodb_client_insert_to_collection(MongoDBClient *client, const char *coll
 
 void mongodb_client_print_stats() {
     printf("\nTotal de documentos inseridos: %d\n", total_documents);
-} 
\ No newline at end of file
+}
+
+void mongodb_client_set_batch_size(MongoDBClient *client, int batch_size) {
+    if (client) client->bulk_size = batch_size > 0 ? batch_size : DEFAULT_BATCH_SIZE;
+}
+
+// Cria o lote sob demanda; lotes não ordenados deixam o servidor paralelizar
+static bool ensure_bulk(MongoDBClient *client) {
+    if (client->bulk) return true;
+
+    bson_t opts;
+    bson_init(&opts);
+    BSON_APPEND_BOOL(&opts, "ordered", false);
+    client->bulk = mongoc_collection_create_bulk_operation_with_opts(client->collection, &opts);
+    bson_destroy(&opts);
+    return client->bulk != NULL;
+}
+
+// Envia o lote automaticamente quando atinge o tamanho configurado
+static bool bulk_added(MongoDBClient *client, const bson_t *doc) {
+    client->bulk_pending++;
+    client->bulk_bytes += doc->len;
+    if (client->bulk_pending >= client->bulk_size) {
+        return mongodb_client_bulk_flush(client);
+    }
+    return true;
+}
+
+bool mongodb_client_bulk_insert(MongoDBClient *client, const bson_t *doc) {
+    if (!client || !client->collection || !doc || !ensure_bulk(client)) return false;
+
+    bson_error_t error;
+    if (!mongoc_bulk_operation_insert_with_opts(client->bulk, doc, NULL, &error)) {
+        mongodb_client_log_write_error("Erro ao adicionar inserção ao lote", error.message);
+        return false;
+    }
+    return bulk_added(client, doc);
+}
+
+bool mongodb_client_bulk_replace(MongoDBClient *client, const bson_t *selector, const bson_t *doc) {
+    if (!client || !client->collection || !selector || !doc || !ensure_bulk(client)) return false;
+
+    bson_t opts;
+    bson_init(&opts);
+    BSON_APPEND_BOOL(&opts, "upsert", true);
+    bson_error_t error;
+    bool result = mongoc_bulk_operation_replace_one_with_opts(client->bulk, selector, doc, &opts, &error);
+    bson_destroy(&opts);
+    if (!result) {
+        mongodb_client_log_write_error("Erro ao adicionar substituição ao lote", error.message);
+        return false;
+    }
+    return bulk_added(client, doc);
+}
+
+bool mongodb_client_bulk_delete(MongoDBClient *client, const bson_t *selector) {
+    if (!client || !client->collection || !selector || !ensure_bulk(client)) return false;
+
+    bson_error_t error;
+    if (!mongoc_bulk_operation_remove_many_with_opts(client->bulk, selector, NULL, &error)) {
+        mongodb_client_log_write_error("Erro ao adicionar remoção ao lote", error.message);
+        return false;
+    }
+    return bulk_added(client, selector);
+}
+
+bool mongodb_client_bulk_flush(MongoDBClient *client) {
+    if (!client) return false;
+    if (!client->bulk || client->bulk_pending == 0) return true;
+
+    // Lotes inteiros passam pelo limitador: o tamanho do lote define a granularidade
+    rate_limiter_acquire(client->bulk_pending, client->bulk_bytes);
+
+    bson_t reply;
+    bson_error_t error;
+    TRACE_BEGIN(TRACE_INSERT);
+    bool result = mongoc_bulk_operation_execute(client->bulk, &reply, &error) != 0;
+    TRACE_END(TRACE_INSERT);
+    if (!result) {
+        mongodb_client_log_write_error("Erro ao executar lote", error.message);
+    }
+
+    bson_destroy(&reply);
+    mongoc_bulk_operation_destroy(client->bulk);
+    client->bulk = NULL;
+    client->bulk_pending = 0;
+    client->bulk_bytes = 0;
+    return result;
+}
@@ -8,8 +8,17 @@ typedef struct {
     mongoc_client_t *client;
     mongoc_database_t *database;
     mongoc_collection_t *collection;
+    mongoc_bulk_operation_t *bulk;  // Lote de escritas pendente
+    int bulk_pending;
+    long bulk_bytes;                // Tamanho BSON das operações pendentes
+    int bulk_size;                  // Operações por lote antes do envio automático
 } MongoDBClient;
 
+// Monta a URI de conexão para a lista de hosts ("host:porta[,host:porta]").
+// Sem usuário, a conexão é feita sem autenticação. options pode ser NULL.
+void mongodb_build_uri(char *uri, size_t size, const char *hosts, const char *username,
+                       const char *password, const char *options);
+
 // Inicializa o cliente MongoDB
 MongoDBClient* mongodb_client_init(const char *uri, const char *database, const char *collection);
 
@@ -23,4 +32,23 @@ bool mongodb_client_insert_to_collection(MongoDBClient *client, const char *coll
 
 void mongodb_client_print_stats();
 
+// Falha de uma escrita: as linhas recusadas já vão para a quarentena, então
+// o log recebe só a 1ª, 10ª, 100ª... falha, com o total até ali
+void mongodb_client_log_write_error(const char *operation, const char *message);
+
+// Define quantas operações são acumuladas antes de enviar o lote
+void mongodb_client_set_batch_size(MongoDBClient *client, int batch_size);
+
+// Acumula uma inserção no lote
+bool mongodb_client_bulk_insert(MongoDBClient *client, const bson_t *doc);
+
+// Acumula a substituição (com upsert) do documento que atende ao seletor
+bool mongodb_client_bulk_replace(MongoDBClient *client, const bson_t *selector, const bson_t *doc);
+
+// Acumula a remoção dos documentos que atendem ao seletor
+bool mongodb_client_bulk_delete(MongoDBClient *client, const bson_t *selector);
+
+// Envia o lote pendente; retorna false se alguma operação falhou
+bool mongodb_client_bulk_flush(MongoDBClient *client);
+
 #endif // MONGODB_CLIENT_H 
\ No newline at end of file
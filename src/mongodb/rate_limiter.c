@@ -0,0 +1,175 @@
+#include "rate_limiter.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#define NS_PER_SEC 1000000000LL
+#define RATE_BURST_NS NS_PER_SEC           // Rajada tolerada: 1 s de escrita no limite
+#define SCHEDULE_CHECK_NS NS_PER_SEC       // Intervalo de reavaliação da agenda
+
+// Bucket GCRA: tat é o instante teórico em que a capacidade reservada se esgota
+typedef struct {
+    int64_t tat;
+    int64_t rate;    // Unidades por segundo; 0 = sem limite
+} Bucket;
+
+static Bucket docs_bucket;
+static Bucket bytes_bucket;
+static int64_t throttled_ns;
+static int64_t next_schedule_check;
+static bool limiter_active;
+
+// A agenda só é lida na reavaliação (no máximo uma vez por segundo) e na
+// reconfiguração; o caminho de cada escrita usa apenas operações atômicas
+static pthread_mutex_t schedule_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long base_docs_per_sec;
+static long base_bytes_per_sec;
+static RateWindow *schedule;
+static int schedule_count;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static bool window_contains(const RateWindow *window, int minute) {
+    if (window->start_minute <= window->end_minute) {
+        return minute >= window->start_minute && minute < window->end_minute;
+    }
+    return minute >= window->start_minute || minute < window->end_minute;
+}
+
+// Aplica os limites da janela atual; chamada com schedule_mutex travado
+static void apply_schedule(int64_t now) {
+    long docs = base_docs_per_sec;
+    long bytes = base_bytes_per_sec;
+
+    if (schedule_count > 0) {
+        time_t wall = time(NULL);
+        struct tm local;
+        localtime_r(&wall, &local);
+        int minute = local.tm_hour * 60 + local.tm_min;
+        for (int i = 0; i < schedule_count; i++) {
+            if (window_contains(&schedule[i], minute)) {
+                docs = schedule[i].docs_per_sec;
+                bytes = schedule[i].bytes_per_sec;
+                break;
+            }
+        }
+    }
+
+    if (__atomic_load_n(&docs_bucket.rate, __ATOMIC_RELAXED) == docs &&
+        __atomic_load_n(&bytes_bucket.rate, __ATOMIC_RELAXED) == bytes) {
+        return;
+    }
+
+    // Reservas feitas no limite anterior não valem para o novo
+    __atomic_store_n(&docs_bucket.rate, (int64_t)docs, __ATOMIC_RELAXED);
+    __atomic_store_n(&bytes_bucket.rate, (int64_t)bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&docs_bucket.tat, now, __ATOMIC_RELAXED);
+    __atomic_store_n(&bytes_bucket.tat, now, __ATOMIC_RELAXED);
+    logger_log(LOG_INFO, "Limite de escrita: %ld docs/s, %ld bytes/s (0 = sem limite)", docs, bytes);
+}
+
+// Uma única thread por intervalo reavalia a agenda; as demais seguem direto
+static void maybe_apply_schedule(int64_t now) {
+    int64_t next = __atomic_load_n(&next_schedule_check, __ATOMIC_RELAXED);
+    if (now < next) return;
+    if (!__atomic_compare_exchange_n(&next_schedule_check, &next, now + SCHEDULE_CHECK_NS,
+                                     false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+    pthread_mutex_lock(&schedule_mutex);
+    apply_schedule(now);
+    pthread_mutex_unlock(&schedule_mutex);
+}
+
+// Reserva `units` no bucket e retorna quanto a thread deve esperar (ns)
+static int64_t reserve(Bucket *bucket, long units, int64_t now) {
+    int64_t rate = __atomic_load_n(&bucket->rate, __ATOMIC_RELAXED);
+    if (rate <= 0 || units <= 0) return 0;
+
+    int64_t cost = (int64_t)((double)units * NS_PER_SEC / (double)rate);
+    int64_t tat = __atomic_load_n(&bucket->tat, __ATOMIC_RELAXED);
+    int64_t next;
+    do {
+        next = (tat > now ? tat : now) + cost;
+    } while (!__atomic_compare_exchange_n(&bucket->tat, &tat, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return next - now - RATE_BURST_NS;
+}
+
+static void sleep_ns(int64_t ns) {
+    struct timespec ts = { ns / NS_PER_SEC, ns % NS_PER_SEC };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+void rate_limiter_acquire(long docs, long bytes) {
+    if (!__atomic_load_n(&limiter_active, __ATOMIC_RELAXED)) return;
+
+    int64_t now = now_ns();
+    maybe_apply_schedule(now);
+
+    int64_t wait = reserve(&docs_bucket, docs, now);
+    int64_t bytes_wait = reserve(&bytes_bucket, bytes, now);
+    if (bytes_wait > wait) wait = bytes_wait;
+    if (wait > 0) {
+        sleep_ns(wait);
+        __atomic_add_fetch(&throttled_ns, wait, __ATOMIC_RELAXED);
+    }
+}
+
+void rate_limiter_configure(const RateLimitConfig *config) {
+    RateWindow *windows = NULL;
+    int count = 0;
+    if (config && config->window_count > 0) {
+        windows = malloc(config->window_count * sizeof(RateWindow));
+        if (windows) {
+            memcpy(windows, config->windows, config->window_count * sizeof(RateWindow));
+            count = config->window_count;
+        }
+    }
+
+    pthread_mutex_lock(&schedule_mutex);
+    free(schedule);
+    schedule = windows;
+    schedule_count = count;
+    base_docs_per_sec = config ? config->docs_per_sec : 0;
+    base_bytes_per_sec = config ? config->bytes_per_sec : 0;
+
+    bool active = base_docs_per_sec > 0 || base_bytes_per_sec > 0 || schedule_count > 0;
+    apply_schedule(now_ns());
+    __atomic_store_n(&next_schedule_check, now_ns() + SCHEDULE_CHECK_NS, __ATOMIC_RELAXED);
+    __atomic_store_n(&limiter_active, active, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&schedule_mutex);
+}
+
+int rate_limiter_parse_time(const char *text) {
+    int hour, minute;
+    char extra;
+    if (!text || sscanf(text, "%d:%d%c", &hour, &minute, &extra) != 2) return -1;
+    if (hour < 0 || hour > 24 || minute < 0 || minute > 59 || (hour == 24 && minute != 0)) return -1;
+    return hour * 60 + minute;
+}
+
+double rate_limiter_throttled_seconds(void) {
+    return (double)__atomic_load_n(&throttled_ns, __ATOMIC_RELAXED) / NS_PER_SEC;
+}
+
+bool rate_limiter_active(void) {
+    return __atomic_load_n(&limiter_active, __ATOMIC_RELAXED);
+}
+
+void rate_limiter_cleanup(void) {
+    pthread_mutex_lock(&schedule_mutex);
+    free(schedule);
+    schedule = NULL;
+    schedule_count = 0;
+    pthread_mutex_unlock(&schedule_mutex);
+}
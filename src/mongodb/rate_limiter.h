@@ -0,0 +1,43 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <stdbool.h>
+
+// Janela do dia com limites próprios; end < start atravessa a meia-noite
+typedef struct {
+    int start_minute;      // Minutos desde 00:00, inclusivo
+    int end_minute;        // Minutos desde 00:00, exclusivo
+    long docs_per_sec;     // 0 = sem limite
+    long bytes_per_sec;    // 0 = sem limite
+} RateWindow;
+
+typedef struct {
+    long docs_per_sec;     // Limite fora das janelas; 0 = sem limite
+    long bytes_per_sec;
+    const RateWindow *windows;
+    int window_count;
+} RateLimitConfig;
+
+// Limitador global de escrita compartilhado por todos os clientes MongoDB.
+// Cada limite é um token bucket no formato GCRA: um único instante teórico
+// de chegada por bucket, reservado com compare-and-swap, sem locks.
+
+// Define (ou redefine em tempo de execução) os limites e a agenda.
+// As janelas são copiadas.
+void rate_limiter_configure(const RateLimitConfig *config);
+
+// Reserva `docs` documentos e `bytes` bytes e dorme até que caibam no limite
+void rate_limiter_acquire(long docs, long bytes);
+
+// Converte "HH:MM" em minutos desde 00:00; -1 se inválido
+int rate_limiter_parse_time(const char *text);
+
+// Tempo total que as threads passaram esperando o limitador, em segundos
+double rate_limiter_throttled_seconds(void);
+
+// Indica se há algum limite ou agenda configurado
+bool rate_limiter_active(void);
+
+void rate_limiter_cleanup(void);
+
+#endif // RATE_LIMITER_H
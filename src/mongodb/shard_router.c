@@ -0,0 +1,643 @@
+#include "shard_router.h"
+#include "mongodb_client.h"
+#include "rate_limiter.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mongoc/mongoc.h>
+
+// Códigos de erro que indicam metadados de roteamento desatualizados
+#define ERROR_STALE_SHARD_VERSION 63
+#define ERROR_STALE_EPOCH 150
+#define ERROR_STALE_CONFIG 13388
+#define MAX_REROUTE_ROUNDS 3
+
+static bool is_stale_error(int code) {
+    return code == ERROR_STALE_CONFIG || code == ERROR_STALE_SHARD_VERSION || code == ERROR_STALE_EPOCH;
+}
+
+// Ordem canônica dos tipos BSON, reduzida ao que importa para chaves string
+static KeyBound bound_from_iter(const bson_iter_t *it) {
+    KeyBound bound = { 3, NULL };
+    switch (bson_iter_type(it)) {
+        case BSON_TYPE_MINKEY: bound.order = 0; break;
+        case BSON_TYPE_MAXKEY: bound.order = 4; break;
+        case BSON_TYPE_NULL:
+        case BSON_TYPE_INT32:
+        case BSON_TYPE_INT64:
+        case BSON_TYPE_DOUBLE:
+            bound.order = 1;
+            break;
+        case BSON_TYPE_UTF8:
+            bound.order = 2;
+            bound.value = strdup(bson_iter_utf8(it, NULL));
+            break;
+        default:
+            break;
+    }
+    return bound;
+}
+
+// Compara um valor (NULL = campo ausente/null) com um limite de chunk
+static int compare_value(const char *value, const KeyBound *bound) {
+    int order = value ? 2 : 1;
+    if (order != bound->order) return order < bound->order ? -1 : 1;
+    if (order != 2) return 0;
+    return strcmp(value, bound->value);
+}
+
+static int compare_bounds(const KeyBound *a, const KeyBound *b) {
+    if (a->order != b->order) return a->order < b->order ? -1 : 1;
+    if (a->order != 2) return 0;
+    return strcmp(a->value, b->value);
+}
+
+static int compare_chunks(const void *a, const void *b) {
+    return compare_bounds(&((const ChunkRange*)a)->min, &((const ChunkRange*)b)->min);
+}
+
+static void free_chunks(ChunkRange *chunks, int count) {
+    for (int i = 0; i < count; i++) {
+        free(chunks[i].min.value);
+        free(chunks[i].max.value);
+    }
+    free(chunks);
+}
+
+// Retorna o índice do shard, registrando-o se for novo
+static int shard_index(ShardRouter *router, const char *id) {
+    for (int i = 0; i < router->shard_count; i++) {
+        if (strcmp(router->shards[i].id, id) == 0) return i;
+    }
+    ShardInfo *shards = realloc(router->shards, (router->shard_count + 1) * sizeof(ShardInfo));
+    if (!shards) return -1;
+    router->shards = shards;
+    router->shards[router->shard_count].id = strdup(id);
+    router->shards[router->shard_count].host = NULL;
+    return router->shard_count++;
+}
+
+// Lê o limite (min ou max) de um chunk: documento com o campo da shard key
+static bool read_bound(const bson_t *chunk, const char *name, const char *shard_key, KeyBound *bound) {
+    bson_iter_t it, child;
+    if (!bson_iter_init_find(&it, chunk, name) || !BSON_ITER_HOLDS_DOCUMENT(&it)) return false;
+    if (!bson_iter_recurse(&it, &child) || !bson_iter_find(&child, shard_key)) return false;
+    *bound = bound_from_iter(&child);
+    return true;
+}
+
+// Lê config.collections, config.chunks e config.shards (chamado com o lock de escrita)
+static bool load_metadata(ShardRouter *router, mongoc_client_t *client) {
+    bson_error_t error;
+    const bson_t *doc;
+    bool ok = false;
+    bson_t uuid_filter;
+    bson_init(&uuid_filter);
+
+    // Shard key da coleção
+    mongoc_collection_t *collections = mongoc_client_get_collection(client, "config", "collections");
+    bson_t filter;
+    bson_init(&filter);
+    BSON_APPEND_UTF8(&filter, "_id", router->namespace);
+    mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(collections, &filter, NULL, NULL);
+    bson_destroy(&filter);
+
+    char *shard_key = NULL;
+    bool has_uuid = false;
+    if (mongoc_cursor_next(cursor, &doc)) {
+        bson_iter_t it, key;
+        bool dropped = bson_iter_init_find(&it, doc, "dropped") && bson_iter_as_bool(&it);
+        if (!dropped && bson_iter_init_find(&it, doc, "key") && BSON_ITER_HOLDS_DOCUMENT(&it) &&
+            bson_iter_recurse(&it, &key) && bson_iter_next(&key)) {
+            if (BSON_ITER_HOLDS_UTF8(&key)) {
+                logger_log(LOG_WARNING, "Shard key hashed em %s não é suportada pelo roteamento", router->namespace);
+            } else {
+                shard_key = strdup(bson_iter_key(&key));
+                if (bson_iter_next(&key)) {
+                    logger_log(LOG_WARNING, "Shard key composta em %s não é suportada pelo roteamento", router->namespace);
+                    free(shard_key);
+                    shard_key = NULL;
+                }
+            }
+        }
+        if (bson_iter_init_find(&it, doc, "uuid")) {
+            bson_append_iter(&uuid_filter, "uuid", -1, &it);
+            has_uuid = true;
+        }
+    } else if (mongoc_cursor_error(cursor, &error)) {
+        logger_log(LOG_ERROR, "Erro ao ler config.collections: %s", error.message);
+    } else {
+        logger_log(LOG_WARNING, "Coleção %s não é particionada", router->namespace);
+    }
+    mongoc_cursor_destroy(cursor);
+    mongoc_collection_destroy(collections);
+
+    if (!shard_key) {
+        bson_destroy(&uuid_filter);
+        return false;
+    }
+    if (router->shard_key && strcmp(router->shard_key, shard_key) != 0) {
+        logger_log(LOG_WARNING, "Shard key de %s mudou de %s para %s", router->namespace, router->shard_key, shard_key);
+    }
+    free(router->shard_key);
+    router->shard_key = shard_key;
+
+    // Chunks: a partir do 5.0 são indexados pelo uuid da coleção, antes pelo ns
+    mongoc_collection_t *chunks_collection = mongoc_client_get_collection(client, "config", "chunks");
+    ChunkRange *chunks = NULL;
+    int chunk_count = 0;
+    for (int attempt = 0; attempt < 2 && chunk_count == 0; attempt++) {
+        bson_t chunk_filter;
+        bson_init(&chunk_filter);
+        if (attempt == 0 && has_uuid) {
+            bson_concat(&chunk_filter, &uuid_filter);
+        } else if (attempt == 0) {
+            bson_destroy(&chunk_filter);
+            continue;
+        } else {
+            BSON_APPEND_UTF8(&chunk_filter, "ns", router->namespace);
+        }
+
+        cursor = mongoc_collection_find_with_opts(chunks_collection, &chunk_filter, NULL, NULL);
+        while (mongoc_cursor_next(cursor, &doc)) {
+            bson_iter_t it;
+            ChunkRange chunk;
+            if (!bson_iter_init_find(&it, doc, "shard") || !BSON_ITER_HOLDS_UTF8(&it)) continue;
+            chunk.shard = shard_index(router, bson_iter_utf8(&it, NULL));
+            if (chunk.shard < 0 ||
+                !read_bound(doc, "min", router->shard_key, &chunk.min) ||
+                !read_bound(doc, "max", router->shard_key, &chunk.max)) continue;
+
+            ChunkRange *grown = realloc(chunks, (chunk_count + 1) * sizeof(ChunkRange));
+            if (!grown) {
+                free(chunk.min.value);
+                free(chunk.max.value);
+                break;
+            }
+            chunks = grown;
+            chunks[chunk_count++] = chunk;
+        }
+        if (mongoc_cursor_error(cursor, &error)) {
+            logger_log(LOG_ERROR, "Erro ao ler config.chunks: %s", error.message);
+        }
+        mongoc_cursor_destroy(cursor);
+        bson_destroy(&chunk_filter);
+    }
+    mongoc_collection_destroy(chunks_collection);
+    bson_destroy(&uuid_filter);
+
+    if (chunk_count == 0) {
+        logger_log(LOG_ERROR, "Nenhum chunk encontrado para %s", router->namespace);
+        free(chunks);
+        return false;
+    }
+    qsort(chunks, chunk_count, sizeof(ChunkRange), compare_chunks);
+    free_chunks(router->chunks, router->chunk_count);
+    router->chunks = chunks;
+    router->chunk_count = chunk_count;
+
+    // Strings de conexão de cada shard
+    mongoc_collection_t *shards = mongoc_client_get_collection(client, "config", "shards");
+    bson_t all;
+    bson_init(&all);
+    cursor = mongoc_collection_find_with_opts(shards, &all, NULL, NULL);
+    while (mongoc_cursor_next(cursor, &doc)) {
+        bson_iter_t id, host;
+        if (!bson_iter_init_find(&id, doc, "_id") || !BSON_ITER_HOLDS_UTF8(&id)) continue;
+        if (!bson_iter_init_find(&host, doc, "host") || !BSON_ITER_HOLDS_UTF8(&host)) continue;
+        int index = shard_index(router, bson_iter_utf8(&id, NULL));
+        if (index < 0) continue;
+        free(router->shards[index].host);
+        router->shards[index].host = strdup(bson_iter_utf8(&host, NULL));
+    }
+    ok = !mongoc_cursor_error(cursor, &error);
+    if (!ok) logger_log(LOG_ERROR, "Erro ao ler config.shards: %s", error.message);
+    mongoc_cursor_destroy(cursor);
+    bson_destroy(&all);
+    mongoc_collection_destroy(shards);
+
+    router->version++;
+    logger_log(LOG_INFO, "Roteamento de %s: shard key %s, %d chunks em %d shards (versão %llu)",
+        router->namespace, router->shard_key, router->chunk_count, router->shard_count,
+        (unsigned long long)router->version);
+    return ok;
+}
+
+static bool reload(ShardRouter *router) {
+    mongoc_client_t *client = mongoc_client_new(router->uri);
+    if (!client) {
+        logger_log(LOG_ERROR, "Erro ao conectar ao mongos para ler metadados de roteamento");
+        return false;
+    }
+    bool ok = load_metadata(router, client);
+    mongoc_client_destroy(client);
+    return ok;
+}
+
+ShardRouter* shard_router_load(const char *uri, const char *database, const char *collection) {
+    ShardRouter *router = calloc(1, sizeof(ShardRouter));
+    if (!router) return NULL;
+
+    mongoc_init();
+    router->uri = strdup(uri);
+    size_t ns_size = strlen(database) + strlen(collection) + 2;
+    router->namespace = malloc(ns_size);
+    if (!router->uri || !router->namespace) {
+        shard_router_free(router);
+        return NULL;
+    }
+    snprintf(router->namespace, ns_size, "%s.%s", database, collection);
+    pthread_rwlock_init(&router->lock, NULL);
+
+    if (!reload(router)) {
+        shard_router_free(router);
+        return NULL;
+    }
+    return router;
+}
+
+bool shard_router_refresh(ShardRouter *router, uint64_t seen_version) {
+    if (!router) return false;
+    pthread_rwlock_wrlock(&router->lock);
+    // Outro worker já atualizou depois do erro que motivou esta chamada
+    bool ok = router->version != seen_version ? true : reload(router);
+    pthread_rwlock_unlock(&router->lock);
+    return ok;
+}
+
+int shard_router_route(ShardRouter *router, const char *key_value, uint64_t *version) {
+    if (!router) return -1;
+    pthread_rwlock_rdlock(&router->lock);
+    if (version) *version = router->version;
+
+    // Último chunk cujo limite inferior é <= valor
+    int low = 0, high = router->chunk_count - 1, found = -1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (compare_value(key_value, &router->chunks[mid].min) >= 0) {
+            found = mid;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    int shard = -1;
+    if (found >= 0 && compare_value(key_value, &router->chunks[found].max) < 0) {
+        shard = router->chunks[found].shard;
+    }
+    pthread_rwlock_unlock(&router->lock);
+    return shard;
+}
+
+static uint64_t current_version(ShardRouter *router) {
+    pthread_rwlock_rdlock(&router->lock);
+    uint64_t version = router->version;
+    pthread_rwlock_unlock(&router->lock);
+    return version;
+}
+
+bool shard_router_shard_host(ShardRouter *router, int shard, char *host, size_t size) {
+    if (!router) return false;
+    pthread_rwlock_rdlock(&router->lock);
+    bool ok = shard >= 0 && shard < router->shard_count && router->shards[shard].host;
+    if (ok) snprintf(host, size, "%s", router->shards[shard].host);
+    pthread_rwlock_unlock(&router->lock);
+    return ok;
+}
+
+void shard_router_free(ShardRouter *router) {
+    if (!router) return;
+    for (int i = 0; i < router->shard_count; i++) {
+        free(router->shards[i].id);
+        free(router->shards[i].host);
+    }
+    free(router->shards);
+    free_chunks(router->chunks, router->chunk_count);
+    free(router->shard_key);
+    free(router->namespace);
+    free(router->uri);
+    pthread_rwlock_destroy(&router->lock);
+    free(router);
+}
+
+// Lote de documentos destinados a um shard
+typedef struct {
+    MongoDBClient *client;   // Conexão direta (NULL = via mongos)
+    bson_t **docs;
+    int *tags;               // Tag de cada documento, devolvido no aviso de conclusão
+    int count;
+    int capacity;
+} ShardBatch;
+
+struct ShardedWriter {
+    ShardRouter *router;
+    char *database;
+    char *collection;
+    char *username;
+    char *password;
+    bool direct;
+    int batch_size;
+    ShardBatch *batches;
+    int batch_count;
+    MongoDBClient *mongos;
+    long written;
+    bool failed;
+    ShardedWriteDone done;
+    void *done_context;
+};
+
+ShardedWriter* sharded_writer_new(ShardRouter *router, const char *database, const char *collection,
+                                  const char *username, const char *password,
+                                  bool direct_connections, int batch_size) {
+    ShardedWriter *writer = calloc(1, sizeof(ShardedWriter));
+    if (!writer) return NULL;
+    writer->router = router;
+    writer->database = strdup(database);
+    writer->collection = strdup(collection);
+    writer->username = username ? strdup(username) : NULL;
+    writer->password = password ? strdup(password) : NULL;
+    writer->direct = direct_connections;
+    writer->batch_size = batch_size > 0 ? batch_size : 1000;
+
+    writer->mongos = mongodb_client_init(router->uri, database, collection);
+    if (!writer->mongos) {
+        sharded_writer_free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+void sharded_writer_on_done(ShardedWriter *writer, ShardedWriteDone done, void *context) {
+    if (!writer) return;
+    writer->done = done;
+    writer->done_context = context;
+}
+
+static void report_done(ShardedWriter *writer, int tag, bool written) {
+    if (writer->done) writer->done(writer->done_context, tag, written);
+}
+
+static ShardBatch* batch_for(ShardedWriter *writer, int shard) {
+    if (shard >= writer->batch_count) {
+        ShardBatch *batches = realloc(writer->batches, (shard + 1) * sizeof(ShardBatch));
+        if (!batches) return NULL;
+        memset(batches + writer->batch_count, 0, (shard + 1 - writer->batch_count) * sizeof(ShardBatch));
+        writer->batches = batches;
+        writer->batch_count = shard + 1;
+    }
+    return &writer->batches[shard];
+}
+
+// Conexão usada para o lote: direta ao shard ou o mongos
+static MongoDBClient* client_for(ShardedWriter *writer, int shard, ShardBatch *batch) {
+    if (!writer->direct) return writer->mongos;
+    if (batch->client) return batch->client;
+
+    // host no formato "rs0/h1:27018,h2:27018" (ou só a lista de hosts)
+    char host[1024];
+    if (!shard_router_shard_host(writer->router, shard, host, sizeof(host))) return writer->mongos;
+    char options[256] = "";
+    char *hosts = host;
+    char *slash = strchr(host, '/');
+    if (slash) {
+        *slash = '\0';
+        snprintf(options, sizeof(options), "replicaSet=%s", host);
+        hosts = slash + 1;
+    }
+
+    char uri[1536];
+    mongodb_build_uri(uri, sizeof(uri), hosts, writer->username, writer->password, options);
+    batch->client = mongodb_client_init(uri, writer->database, writer->collection);
+    if (!batch->client) {
+        logger_log(LOG_WARNING, "Falha na conexão direta ao shard %s, usando o mongos", hosts);
+        return writer->mongos;
+    }
+    logger_log(LOG_INFO, "Conexão direta ao shard %d: %s", shard, hosts);
+    return batch->client;
+}
+
+static bool add_to_batch(ShardedWriter *writer, bson_t *doc, int tag, uint64_t *version) {
+    const char *key = NULL;
+    bson_iter_t it;
+    if (bson_iter_init_find(&it, doc, writer->router->shard_key) && BSON_ITER_HOLDS_UTF8(&it)) {
+        key = bson_iter_utf8(&it, NULL);
+    }
+
+    int shard = shard_router_route(writer->router, key, version);
+    if (shard < 0) {
+        // Buraco nos chunks: metadados em transição, tenta uma atualização
+        shard_router_refresh(writer->router, *version);
+        shard = shard_router_route(writer->router, key, version);
+    }
+    ShardBatch *batch = shard >= 0 ? batch_for(writer, shard) : NULL;
+    if (!batch) return false;
+
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity ? batch->capacity * 2 : writer->batch_size;
+        bson_t **docs = realloc(batch->docs, capacity * sizeof(bson_t*));
+        if (!docs) return false;
+        batch->docs = docs;
+        int *tags = realloc(batch->tags, capacity * sizeof(int));
+        if (!tags) return false;
+        batch->tags = tags;
+        batch->capacity = capacity;
+    }
+    batch->tags[batch->count] = tag;
+    batch->docs[batch->count++] = doc;
+    return true;
+}
+
+// Envia o lote de um shard. Documentos recusados por metadados desatualizados
+// voltam para os lotes depois da atualização do roteamento.
+static bool flush_batch(ShardedWriter *writer, int shard) {
+    ShardBatch *batch = &writer->batches[shard];
+    if (batch->count == 0) return true;
+
+    MongoDBClient *client = client_for(writer, shard, batch);
+    bson_t opts;
+    bson_init(&opts);
+    BSON_APPEND_BOOL(&opts, "ordered", false);
+    mongoc_bulk_operation_t *bulk = mongoc_collection_create_bulk_operation_with_opts(client->collection, &opts);
+    bson_destroy(&opts);
+
+    // Situação de cada documento (0 ok, 1 reenviar, 2 falhou) e a sua
+    // posição no lote; os que o driver recusa ao montar ficam de fora
+    unsigned char *status = calloc(batch->count, 1);
+    int *positions = malloc(batch->count * sizeof(int));
+    if (!bulk || !status || !positions) {
+        if (bulk) mongoc_bulk_operation_destroy(bulk);
+        free(status);
+        free(positions);
+        return false;
+    }
+
+    bson_error_t error;
+    long bytes = 0;
+    int queued = 0;
+    int failures = 0;
+    for (int i = 0; i < batch->count; i++) {
+        if (!mongoc_bulk_operation_insert_with_opts(bulk, batch->docs[i], NULL, &error)) {
+            mongodb_client_log_write_error("Documento recusado ao montar o lote de um shard", error.message);
+            status[i] = 2;
+            failures++;
+            continue;
+        }
+        positions[queued++] = i;
+        bytes += batch->docs[i]->len;
+    }
+
+    bson_t reply;
+    bson_init(&reply);
+    bool executed = true;
+    uint64_t version = current_version(writer->router);
+    if (queued > 0) {
+        rate_limiter_acquire(queued, bytes);
+        bson_destroy(&reply);
+        executed = mongoc_bulk_operation_execute(bulk, &reply, &error) != 0;
+    }
+    mongoc_bulk_operation_destroy(bulk);
+
+    // Classifica cada documento pelo erro retornado (índice = posição no lote).
+    // Chave duplicada também é falha: o _id é gerado aqui e documentos
+    // recusados por metadados desatualizados não foram gravados, então só
+    // um índice único secundário gera esse erro.
+    bool stale = false;
+    bson_iter_t it, errors;
+    bool has_write_errors = bson_iter_init_find(&it, &reply, "writeErrors") && bson_iter_recurse(&it, &errors);
+    if (!executed && !has_write_errors) {
+        // Erro de comando: o lote inteiro volta (se desatualizado) ou falha
+        stale = is_stale_error((int)error.code);
+        for (int i = 0; i < queued; i++) status[positions[i]] = stale ? 1 : 2;
+        if (!stale) {
+            logger_log(LOG_ERROR, "Erro ao enviar lote ao shard %d: %s", shard, error.message);
+            failures += queued;
+        }
+    }
+    while (has_write_errors && bson_iter_next(&errors)) {
+        bson_iter_t field;
+        int index = -1, code = 0;
+        if (!bson_iter_recurse(&errors, &field)) continue;
+        while (bson_iter_next(&field)) {
+            if (strcmp(bson_iter_key(&field), "index") == 0) index = (int)bson_iter_as_int64(&field);
+            if (strcmp(bson_iter_key(&field), "code") == 0) code = (int)bson_iter_as_int64(&field);
+        }
+        if (index < 0 || index >= queued || status[positions[index]] != 0) continue;
+        if (is_stale_error(code)) {
+            status[positions[index]] = 1;
+            stale = true;
+        } else {
+            status[positions[index]] = 2;
+            failures++;
+        }
+    }
+    bson_destroy(&reply);
+    free(positions);
+
+    if (stale) {
+        logger_log(LOG_WARNING, "Shard %d informou metadados desatualizados, atualizando roteamento", shard);
+        shard_router_refresh(writer->router, version);
+    }
+
+    // Retira os documentos do lote antes de reenfileirar os recusados
+    bson_t **docs = batch->docs;
+    int *tags = batch->tags;
+    int count = batch->count;
+    batch->docs = NULL;
+    batch->tags = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+
+    for (int i = 0; i < count; i++) {
+        int s = status[i];
+        if (s == 1 && add_to_batch(writer, docs[i], tags[i], &version)) continue;
+        if (s == 1) failures++;  // Sem memória para reenfileirar
+        if (s == 0) writer->written++;
+        report_done(writer, tags[i], s == 0);
+        bson_destroy(docs[i]);
+    }
+    bool ok = failures == 0;
+    free(docs);
+    free(tags);
+    free(status);
+    if (failures > 0) logger_log(LOG_ERROR, "Shard %d: %d documentos recusados", shard, failures);
+    return ok;
+}
+
+bool sharded_writer_insert(ShardedWriter *writer, const bson_t *doc, int tag) {
+    if (!writer || !doc) return false;
+
+    // O _id é gerado aqui para que um reenvio não duplique documentos
+    bson_t *copy = bson_new();
+    if (!bson_has_field(doc, "_id")) {
+        bson_oid_t oid;
+        bson_oid_init(&oid, NULL);
+        BSON_APPEND_OID(copy, "_id", &oid);
+    }
+    bson_concat(copy, doc);
+
+    uint64_t version;
+    if (!add_to_batch(writer, copy, tag, &version)) {
+        bson_destroy(copy);
+        report_done(writer, tag, false);
+        return false;
+    }
+
+    // Envia os lotes que completaram
+    bool ok = true;
+    for (int s = 0; s < writer->batch_count; s++) {
+        if (writer->batches[s].count >= writer->batch_size) ok = flush_batch(writer, s) && ok;
+    }
+    if (!ok) writer->failed = true;
+    return ok;
+}
+
+bool sharded_writer_flush(ShardedWriter *writer) {
+    if (!writer) return false;
+    bool ok = true;
+
+    // Documentos reenfileirados podem cair em outro shard: algumas rodadas
+    for (int round = 0; round < MAX_REROUTE_ROUNDS; round++) {
+        bool pending = false;
+        for (int s = 0; s < writer->batch_count; s++) {
+            if (writer->batches[s].count > 0) {
+                ok = flush_batch(writer, s) && ok;
+                pending = true;
+            }
+        }
+        if (!pending) break;
+    }
+    for (int s = 0; s < writer->batch_count; s++) {
+        if (writer->batches[s].count > 0) {
+            logger_log(LOG_ERROR, "Shard %d: %d documentos não enviados após %d tentativas",
+                s, writer->batches[s].count, MAX_REROUTE_ROUNDS);
+            ok = false;
+        }
+    }
+    return ok && !writer->failed;
+}
+
+long sharded_writer_written(const ShardedWriter *writer) {
+    return writer ? writer->written : 0;
+}
+
+void sharded_writer_free(ShardedWriter *writer) {
+    if (!writer) return;
+    if (writer->batches) sharded_writer_flush(writer);
+    for (int s = 0; s < writer->batch_count; s++) {
+        for (int i = 0; i < writer->batches[s].count; i++) {
+            report_done(writer, writer->batches[s].tags[i], false);
+            bson_destroy(writer->batches[s].docs[i]);
+        }
+        free(writer->batches[s].docs);
+        free(writer->batches[s].tags);
+        mongodb_client_close(writer->batches[s].client);
+    }
+    free(writer->batches);
+    mongodb_client_close(writer->mongos);
+    free(writer->database);
+    free(writer->collection);
+    free(writer->username);
+    free(writer->password);
+    free(writer);
+}
@@ -0,0 +1,85 @@
+#ifndef SHARD_ROUTER_H
+#define SHARD_ROUTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <bson/bson.h>
+
+// Limite de um chunk, comparável a valores string da shard key
+typedef struct {
+    int order;     // Ordem do tipo BSON: 0 MinKey, 1 abaixo de string, 2 string, 3 acima, 4 MaxKey
+    char *value;   // Valor quando order == 2
+} KeyBound;
+
+typedef struct {
+    KeyBound min;
+    KeyBound max;
+    int shard;     // Índice em ShardRouter.shards
+} ChunkRange;
+
+typedef struct {
+    char *id;      // _id em config.shards
+    char *host;    // "rs0/host1:27018,host2:27018"
+} ShardInfo;
+
+// Tabela de roteamento da coleção, compartilhada por todos os workers
+typedef struct {
+    char *uri;            // URI do mongos
+    char *namespace;      // "banco.coleção"
+    char *shard_key;      // Campo (único) da shard key
+    ShardInfo *shards;    // Só cresce: o índice de um shard nunca muda
+    int shard_count;
+    ChunkRange *chunks;   // Ordenados pelo limite inferior
+    int chunk_count;
+    uint64_t version;     // Incrementada a cada atualização dos metadados
+    pthread_rwlock_t lock;
+} ShardRouter;
+
+// Lê shard key, shards e chunks da coleção no config database via mongos.
+// Retorna NULL se a coleção não for particionada ou a shard key não for suportada.
+ShardRouter* shard_router_load(const char *uri, const char *database, const char *collection);
+
+// Relê os metadados, se ainda estiverem na versão informada
+bool shard_router_refresh(ShardRouter *router, uint64_t seen_version);
+
+// Retorna o shard do valor da shard key (-1 se nenhum chunk o contém)
+int shard_router_route(ShardRouter *router, const char *key_value, uint64_t *version);
+
+// Copia a string de conexão do shard (para conexões diretas)
+bool shard_router_shard_host(ShardRouter *router, int shard, char *host, size_t size);
+
+// Libera o roteador
+void shard_router_free(ShardRouter *router);
+
+// Acumula documentos em lotes por shard; um por worker
+typedef struct ShardedWriter ShardedWriter;
+
+// Cria o writer. Com direct_connections, cada shard recebe uma conexão
+// própria (credenciais do shard); sem, os lotes vão pelo mongos.
+ShardedWriter* sharded_writer_new(ShardRouter *router, const char *database, const char *collection,
+                                  const char *username, const char *password,
+                                  bool direct_connections, int batch_size);
+
+// Avisado uma vez por documento, com o tag recebido em sharded_writer_insert:
+// written = true quando o shard confirmou, false quando o documento foi
+// recusado ou não pôde ser enviado
+typedef void (*ShardedWriteDone)(void *context, int tag, bool written);
+
+// Registra o aviso de conclusão de cada documento
+void sharded_writer_on_done(ShardedWriter *writer, ShardedWriteDone done, void *context);
+
+// Roteia e acumula o documento; envia o lote do shard quando completo.
+// Retorna false se o documento ou algum lote enviado agora falhou.
+bool sharded_writer_insert(ShardedWriter *writer, const bson_t *doc, int tag);
+
+// Envia todos os lotes pendentes
+bool sharded_writer_flush(ShardedWriter *writer);
+
+// Documentos confirmados pelo servidor
+long sharded_writer_written(const ShardedWriter *writer);
+
+// Libera o writer (enviando o que estiver pendente)
+void sharded_writer_free(ShardedWriter *writer);
+
+#endif // SHARD_ROUTER_H
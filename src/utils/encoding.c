@@ -0,0 +1,223 @@
+#include "encoding.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Cada byte de entrada gera no máximo 3 bytes UTF-8 (U+20AC e U+FFFD)
+#define MAX_EXPANSION 3
+
+// Sequência UTF-8 de um byte alto; length 0 marca byte indefinido
+typedef struct {
+    uint8_t length;
+    uint8_t bytes[3];
+} Utf8Sequence;
+
+static Utf8Sequence latin1_table[128];
+static Utf8Sequence windows1252_table[128];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+// Windows-1252 0x80-0x9F; 0 nas posições indefinidas (0x81, 0x8D, 0x8F, 0x90, 0x9D)
+static const uint16_t windows1252_c1[32] = {
+    0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,
+    0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178
+};
+
+static const uint8_t replacement[3] = { 0xEF, 0xBF, 0xBD };  // U+FFFD
+
+static Utf8Sequence encode_code_point(uint16_t code_point) {
+    Utf8Sequence seq = {0};
+    if (code_point == 0) return seq;
+    if (code_point < 0x800) {
+        seq.length = 2;
+        seq.bytes[0] = (uint8_t)(0xC0 | (code_point >> 6));
+        seq.bytes[1] = (uint8_t)(0x80 | (code_point & 0x3F));
+    } else {
+        seq.length = 3;
+        seq.bytes[0] = (uint8_t)(0xE0 | (code_point >> 12));
+        seq.bytes[1] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+        seq.bytes[2] = (uint8_t)(0x80 | (code_point & 0x3F));
+    }
+    return seq;
+}
+
+static void build_tables(void) {
+    for (int i = 0; i < 128; i++) {
+        uint16_t byte = (uint16_t)(0x80 + i);
+        latin1_table[i] = encode_code_point(byte);
+        windows1252_table[i] = encode_code_point(i < 32 ? windows1252_c1[i] : byte);
+    }
+}
+
+bool encoding_parse(const char *name, InputEncoding *encoding) {
+    if (!name || !*name || strcasecmp(name, "utf-8") == 0 || strcasecmp(name, "utf8") == 0) {
+        *encoding = INPUT_ENCODING_UTF8;
+    } else if (strcasecmp(name, "latin1") == 0 || strcasecmp(name, "iso-8859-1") == 0) {
+        *encoding = INPUT_ENCODING_LATIN1;
+    } else if (strcasecmp(name, "windows-1252") == 0 || strcasecmp(name, "cp1252") == 0) {
+        *encoding = INPUT_ENCODING_WINDOWS1252;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* encoding_name(InputEncoding encoding) {
+    switch (encoding) {
+        case INPUT_ENCODING_LATIN1: return "latin1";
+        case INPUT_ENCODING_WINDOWS1252: return "windows-1252";
+        default: return "utf-8";
+    }
+}
+
+// Tamanho do trecho inicial só com ASCII: 16 bytes por vez com SSE2,
+// 8 bytes por vez nas demais arquiteturas
+static size_t ascii_prefix(const char *data, size_t length) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= length; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(data + i)));
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+#endif
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word & 0x8080808080808080ULL) break;
+    }
+    while (i < length && !(data[i] & 0x80)) i++;
+    return i;
+}
+
+// Tamanho da sequência UTF-8 válida que começa em `data`, ou 0 se inválida
+static size_t utf8_sequence_length(const uint8_t *data, size_t available) {
+    uint8_t lead = data[0];
+    size_t length;
+    uint8_t min = 0x80, max = 0xBF;  // Faixa do primeiro byte de continuação
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) min = 0xA0;        // Forma não mínima
+        if (lead == 0xED) max = 0x9F;        // Surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) min = 0x90;        // Forma não mínima
+        if (lead == 0xF4) max = 0x8F;        // Acima de U+10FFFF
+    } else {
+        return 0;
+    }
+
+    if (available < length) return 0;
+    if (data[1] < min || data[1] > max) return 0;
+    for (size_t i = 2; i < length; i++) {
+        if ((data[i] & 0xC0) != 0x80) return 0;
+    }
+    return length;
+}
+
+// Fim do trecho que já é UTF-8 válido, a partir de `start`
+static size_t utf8_valid_prefix(const char *data, size_t length, size_t start) {
+    size_t i = start;
+    while (i < length) {
+        i += ascii_prefix(data + i, length - i);
+        if (i >= length) break;
+        size_t seq = utf8_sequence_length((const uint8_t*)data + i, length - i);
+        if (!seq) break;
+        i += seq;
+    }
+    return i;
+}
+
+static bool reserve(TranscodeBuffer *buffer, size_t needed) {
+    if (buffer->capacity >= needed) return true;
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < needed) capacity *= 2;
+    char *data = realloc(buffer->data, capacity);
+    if (!data) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+const char* transcode_line(InputEncoding encoding, const char *line, size_t length,
+                           TranscodeBuffer *buffer, size_t *out_length, long *invalid) {
+    // Caminho rápido: a maioria das linhas é ASCII puro e segue sem cópia
+    size_t ascii = ascii_prefix(line, length);
+    if (ascii == length) {
+        *out_length = length;
+        return line;
+    }
+
+    // Em UTF-8, linhas válidas (acentos no nome, por exemplo) também seguem
+    // sem cópia; só uma sequência inválida obriga a reescrever a linha
+    size_t valid = ascii;
+    if (encoding == INPUT_ENCODING_UTF8) {
+        valid = utf8_valid_prefix(line, length, ascii);
+        if (valid == length) {
+            *out_length = length;
+            return line;
+        }
+    }
+
+    if (!reserve(buffer, length * MAX_EXPANSION + 1)) return NULL;
+    pthread_once(&tables_once, build_tables);
+    const Utf8Sequence *table = encoding == INPUT_ENCODING_LATIN1 ? latin1_table : windows1252_table;
+
+    const uint8_t *in = (const uint8_t*)line;
+    uint8_t *out = (uint8_t*)buffer->data;
+    size_t i = 0;
+    while (i < length) {
+        // Copia de uma vez o trecho ASCII (ou já validado) até o próximo byte alto
+        size_t run = i == 0 ? valid : ascii_prefix(line + i, length - i);
+        memcpy(out, in + i, run);
+        out += run;
+        i += run;
+        if (i >= length) break;
+
+        if (encoding == INPUT_ENCODING_UTF8) {
+            size_t seq = utf8_sequence_length(in + i, length - i);
+            if (seq) {
+                memcpy(out, in + i, seq);
+                out += seq;
+                i += seq;
+                continue;
+            }
+            memcpy(out, replacement, sizeof(replacement));
+            out += sizeof(replacement);
+            (*invalid)++;
+            i++;
+            continue;
+        }
+
+        const Utf8Sequence *seq = &table[in[i] - 0x80];
+        if (seq->length) {
+            memcpy(out, seq->bytes, seq->length);
+            out += seq->length;
+        } else {
+            memcpy(out, replacement, sizeof(replacement));
+            out += sizeof(replacement);
+            (*invalid)++;
+        }
+        i++;
+    }
+
+    *out = '\0';
+    *out_length = (size_t)(out - (uint8_t*)buffer->data);
+    return buffer->data;
+}
+
+void transcode_buffer_free(TranscodeBuffer *buffer) {
+    if (!buffer) return;
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->capacity = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Codificação dos arquivos de entrada; o MongoDB sempre recebe UTF-8
+typedef enum {
+    INPUT_ENCODING_UTF8,         // Apenas valida; sequências inválidas viram U+FFFD
+    INPUT_ENCODING_LATIN1,       // ISO-8859-1
+    INPUT_ENCODING_WINDOWS1252   // Latin-1 com 0x80-0x9F de Windows
+} InputEncoding;
+
+// Buffer de saída reaproveitado entre as linhas de um worker
+typedef struct {
+    char *data;
+    size_t capacity;
+} TranscodeBuffer;
+
+// Converte o nome da codificação ("utf-8", "latin1", "windows-1252", ...)
+bool encoding_parse(const char *name, InputEncoding *encoding);
+
+const char* encoding_name(InputEncoding encoding);
+
+// Converte a linha para UTF-8. Linhas só com ASCII, ou em UTF-8 já válido,
+// são devolvidas sem cópia; as demais são escritas em `buffer` (terminadas em '\0'). O tamanho da linha
+// convertida vai para `out_length` e as sequências inválidas somam em `invalid`.
+// Retorna NULL se não houver memória para o buffer.
+const char* transcode_line(InputEncoding encoding, const char *line, size_t length,
+                           TranscodeBuffer *buffer, size_t *out_length, long *invalid);
+
+void transcode_buffer_free(TranscodeBuffer *buffer);
+
+#endif // ENCODING_H
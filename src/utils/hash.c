@@ -0,0 +1,33 @@
+#include "hash.h"
+#include <string.h>
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hash_bytes(const void *data, size_t length, uint64_t seed) {
+    const unsigned char *p = (const unsigned char*)data;
+    uint64_t h = seed ^ (length * HASH_PRIME_1);
+
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        h ^= mix(word * HASH_PRIME_2);
+        h = (h << 27 | h >> 37) * HASH_PRIME_1 + 0x52dce729;
+        p += 8;
+        length -= 8;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, p, length);
+    h ^= mix(tail * HASH_PRIME_2 + length);
+    return mix(h);
+}
@@ -0,0 +1,11 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hash não criptográfico de 64 bits, processando 8 bytes por vez.
+// Usado para fingerprints de linhas e hash de conteúdo de arquivos.
+uint64_t hash_bytes(const void *data, size_t length, uint64_t seed);
+
+#endif // HASH_H
@@ -0,0 +1,177 @@
+#include "perfect_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define MAX_SEED_ATTEMPTS 100000
+
+// FNV-1a de 64 bits com semente misturada no estado inicial
+static uint64_t hash_with_seed(const char *key, size_t length, uint32_t seed) {
+    uint64_t h = 14695981039346656037ULL ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    // Finalizador para espalhar os bits altos nos baixos
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+typedef struct {
+    uint32_t bucket;
+    int *members;
+    int member_count;
+} Bucket;
+
+static int compare_buckets(const void *a, const void *b) {
+    const Bucket *x = (const Bucket*)a;
+    const Bucket *y = (const Bucket*)b;
+    return y->member_count - x->member_count;
+}
+
+// Tenta posicionar todas as chaves com o número de posições informado
+static bool try_build(PerfectHash *hash, uint32_t slot_count) {
+    int n = hash->key_count;
+    hash->slot_count = slot_count;
+    hash->bucket_count = (uint32_t)(n / 2) + 1;
+
+    hash->seeds = calloc(hash->bucket_count, sizeof(uint32_t));
+    hash->slots = malloc(slot_count * sizeof(int));
+    Bucket *buckets = calloc(hash->bucket_count, sizeof(Bucket));
+    int *members = malloc((n > 0 ? n : 1) * sizeof(int));
+    uint32_t *key_bucket = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    uint32_t *candidate = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+    bool ok = hash->seeds && hash->slots && buckets && members && key_bucket && candidate;
+
+    if (ok) {
+        for (uint32_t i = 0; i < slot_count; i++) hash->slots[i] = -1;
+
+        // Agrupa as chaves por bucket (primeiro nível)
+        for (int i = 0; i < n; i++) {
+            key_bucket[i] = (uint32_t)(hash_with_seed(hash->keys[i], strlen(hash->keys[i]), 0) % hash->bucket_count);
+            buckets[key_bucket[i]].member_count++;
+        }
+        int offset = 0;
+        for (uint32_t b = 0; b < hash->bucket_count; b++) {
+            buckets[b].bucket = b;
+            buckets[b].members = members + offset;
+            offset += buckets[b].member_count;
+            buckets[b].member_count = 0;
+        }
+        for (int i = 0; i < n; i++) {
+            Bucket *bucket = &buckets[key_bucket[i]];
+            bucket->members[bucket->member_count++] = i;
+        }
+
+        // Buckets maiores primeiro: procura um deslocamento sem colisões
+        qsort(buckets, hash->bucket_count, sizeof(Bucket), compare_buckets);
+        for (uint32_t b = 0; ok && b < hash->bucket_count && buckets[b].member_count > 0; b++) {
+            Bucket *bucket = &buckets[b];
+            bool placed = false;
+
+            for (uint32_t seed = 1; seed < MAX_SEED_ATTEMPTS && !placed; seed++) {
+                placed = true;
+                for (int m = 0; m < bucket->member_count && placed; m++) {
+                    const char *key = hash->keys[bucket->members[m]];
+                    candidate[m] = (uint32_t)(hash_with_seed(key, strlen(key), seed) % slot_count);
+                    if (hash->slots[candidate[m]] != -1) placed = false;
+                    for (int prev = 0; prev < m && placed; prev++) {
+                        if (candidate[prev] == candidate[m]) placed = false;
+                    }
+                }
+                if (placed) {
+                    hash->seeds[bucket->bucket] = seed;
+                    for (int m = 0; m < bucket->member_count; m++) {
+                        hash->slots[candidate[m]] = bucket->members[m];
+                    }
+                }
+            }
+            if (!placed) ok = false;
+        }
+    }
+
+    free(buckets);
+    free(members);
+    free(key_bucket);
+    free(candidate);
+    if (!ok) {
+        free(hash->seeds);
+        free(hash->slots);
+        hash->seeds = NULL;
+        hash->slots = NULL;
+    }
+    return ok;
+}
+
+PerfectHash* perfect_hash_build(const char **keys, int key_count) {
+    if (!keys || key_count < 0) return NULL;
+
+    // Chaves repetidas tornariam a tabela ambígua
+    for (int i = 0; i < key_count; i++) {
+        for (int j = i + 1; j < key_count; j++) {
+            if (strcmp(keys[i], keys[j]) == 0) {
+                fprintf(stderr, "Erro: chave duplicada na tabela hash perfeita: %s\n", keys[i]);
+                return NULL;
+            }
+        }
+    }
+
+    PerfectHash *hash = calloc(1, sizeof(PerfectHash));
+    if (!hash) return NULL;
+
+    hash->key_count = key_count;
+    hash->keys = calloc(key_count > 0 ? key_count : 1, sizeof(char*));
+    if (!hash->keys) {
+        free(hash);
+        return NULL;
+    }
+    for (int i = 0; i < key_count; i++) {
+        hash->keys[i] = strdup(keys[i]);
+        if (!hash->keys[i]) {
+            perfect_hash_free(hash);
+            return NULL;
+        }
+    }
+
+    // Começa com ~1,25 posição por chave e cresce se não encontrar solução
+    uint32_t slot_count = (uint32_t)key_count + (uint32_t)key_count / 4 + 1;
+    while (!try_build(hash, slot_count)) {
+        if (slot_count > (uint32_t)key_count * 8 + 8) {
+            fprintf(stderr, "Erro: não foi possível construir a tabela hash perfeita\n");
+            perfect_hash_free(hash);
+            return NULL;
+        }
+        slot_count *= 2;
+    }
+    return hash;
+}
+
+int perfect_hash_lookup(const PerfectHash *hash, const char *key, size_t key_length) {
+    if (!hash || !key || hash->key_count == 0) return -1;
+
+    uint32_t bucket = (uint32_t)(hash_with_seed(key, key_length, 0) % hash->bucket_count);
+    uint32_t slot = (uint32_t)(hash_with_seed(key, key_length, hash->seeds[bucket]) % hash->slot_count);
+    int index = hash->slots[slot];
+    if (index < 0) return -1;
+
+    // Confirma a chave: strings fora do conjunto também caem em alguma posição
+    const char *candidate = hash->keys[index];
+    if (strncmp(candidate, key, key_length) != 0 || candidate[key_length] != '\0') return -1;
+    return index;
+}
+
+void perfect_hash_free(PerfectHash *hash) {
+    if (!hash) return;
+    if (hash->keys) {
+        for (int i = 0; i < hash->key_count; i++) {
+            free(hash->keys[i]);
+        }
+        free(hash->keys);
+    }
+    free(hash->seeds);
+    free(hash->slots);
+    free(hash);
+}
@@ -0,0 +1,29 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tabela hash perfeita (hash-and-displace) para um conjunto fixo de strings.
+// É construída uma vez na inicialização; cada busca custa dois hashes e uma
+// comparação, sem colisões a percorrer.
+typedef struct {
+    uint32_t bucket_count;
+    uint32_t slot_count;
+    uint32_t *seeds;   // Deslocamento escolhido para cada bucket
+    int *slots;        // Índice da chave em cada posição (-1 = vazia)
+    char **keys;       // Cópia das chaves, na ordem recebida
+    int key_count;
+} PerfectHash;
+
+// Constrói a tabela para as chaves informadas (que não podem se repetir).
+// Retorna NULL em caso de chave duplicada ou falta de memória.
+PerfectHash* perfect_hash_build(const char **keys, int key_count);
+
+// Retorna o índice da chave (na ordem de construção) ou -1 se não existir
+int perfect_hash_lookup(const PerfectHash *hash, const char *key, size_t key_length);
+
+// Libera a tabela
+void perfect_hash_free(PerfectHash *hash);
+
+#endif // PERFECT_HASH_H
@@ -77,4 +77,31 @@ void free_string_array(char **array, int count) {
         }
     }
     free(array);
-} 
\ No newline at end of file
+}
+
+int split_fields_lazy(const char *line, size_t length, char delim, int max_column, FieldSpan *spans) {
+    if (!line || !spans || max_column < 0) return 0;
+
+    const char *p = line;
+    const char *end = line + length;
+    int count = 0;
+
+    // Para no delimitador que encerra max_column: o resto da linha é ignorado
+    while (count <= max_column) {
+        const char *next = memchr(p, delim, (size_t)(end - p));
+        const char *field_end = next ? next : end;
+        spans[count].start = p;
+        spans[count].length = (int)(field_end - p);
+        count++;
+        if (!next) break;
+        p = next + 1;
+    }
+    return count;
+}
+
+void span_unquote(FieldSpan *span) {
+    if (span->length >= 2 && span->start[0] == '"' && span->start[span->length - 1] == '"') {
+        span->start++;
+        span->length -= 2;
+    }
+}
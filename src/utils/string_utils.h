@@ -9,4 +9,18 @@ int split_string(const char *str, const char *delim, char ***result);
 // Libera um array de strings alocado por split_string
 void free_string_array(char **array, int count);
 
+// Trecho de uma linha (sem cópia e sem terminador)
+typedef struct {
+    const char *start;
+    int length;
+} FieldSpan;
+
+// Localiza os campos da linha só até a coluna max_column (0-based), sem copiar.
+// spans deve ter espaço para max_column + 1 posições.
+// Retorna o número de campos localizados.
+int split_fields_lazy(const char *line, size_t length, char delim, int max_column, FieldSpan *spans);
+
+// Remove as aspas ao redor do campo ajustando o trecho, sem copiar
+void span_unquote(FieldSpan *span);
+
 #endif // STRING_UTILS_H 
\ No newline at end of file
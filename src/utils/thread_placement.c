@@ -0,0 +1,176 @@
+#define _GNU_SOURCE
+#include "thread_placement.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+static ThreadPlacementConfig placement;
+static bool placement_enabled = false;
+
+#ifdef HAVE_LIBNUMA
+// CPUs permitidas ao processo, agrupadas por nó NUMA
+typedef struct {
+    int node;
+    int *cpus;
+    int cpu_count;
+} NumaNode;
+
+static NumaNode *nodes = NULL;
+static int node_count = 0;
+static int total_cpus = 0;
+
+// Monta a lista de CPUs de cada nó respeitando a afinidade herdada pelo processo
+static bool load_topology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        logger_log(LOG_WARNING, "Não foi possível obter a afinidade do processo");
+        return false;
+    }
+
+    struct bitmask *cpumask = numa_allocate_cpumask();
+    if (!cpumask) return false;
+
+    int max_node = numa_max_node();
+    nodes = calloc(max_node + 1, sizeof(NumaNode));
+    if (!nodes) {
+        numa_free_cpumask(cpumask);
+        return false;
+    }
+
+    for (int n = 0; n <= max_node; n++) {
+        if (!numa_bitmask_isbitset(numa_all_nodes_ptr, n)) continue;
+        if (numa_node_to_cpus(n, cpumask) != 0) continue;
+
+        NumaNode *node = &nodes[node_count];
+        node->node = n;
+        node->cpus = malloc(cpumask->size * sizeof(int));
+        if (!node->cpus) continue;
+
+        for (unsigned int cpu = 0; cpu < cpumask->size && cpu < CPU_SETSIZE; cpu++) {
+            if (numa_bitmask_isbitset(cpumask, cpu) && CPU_ISSET(cpu, &allowed)) {
+                node->cpus[node->cpu_count++] = (int)cpu;
+            }
+        }
+
+        if (node->cpu_count == 0) {
+            free(node->cpus);
+            node->cpus = NULL;
+            continue;
+        }
+        total_cpus += node->cpu_count;
+        node_count++;
+    }
+
+    numa_free_cpumask(cpumask);
+    return node_count > 0;
+}
+#endif
+
+void thread_placement_init(const ThreadPlacementConfig *config) {
+    if (!config) return;
+    placement = *config;
+
+    if (!placement.pin_threads && !placement.numa_local_memory && !placement.numa_spread) {
+        logger_log(LOG_INFO, "Posicionamento de threads: desativado");
+        return;
+    }
+
+#ifdef HAVE_LIBNUMA
+    if (numa_available() < 0) {
+        logger_log(LOG_WARNING, "Posicionamento de threads: NUMA indisponível neste host, ignorando");
+        return;
+    }
+
+    if (!load_topology()) {
+        logger_log(LOG_WARNING, "Posicionamento de threads: falha ao ler a topologia, ignorando");
+        thread_placement_cleanup();
+        return;
+    }
+
+    placement_enabled = true;
+    logger_log(LOG_INFO, "Posicionamento de threads: %d nó(s) NUMA, %d CPU(s) disponíveis "
+        "(fixar núcleos: %s, memória local: %s, round-robin entre nós: %s)",
+        node_count, total_cpus,
+        placement.pin_threads ? "sim" : "não",
+        placement.numa_local_memory ? "sim" : "não",
+        placement.numa_spread ? "sim" : "não");
+    for (int i = 0; i < node_count; i++) {
+        logger_log(LOG_INFO, "Nó NUMA %d: %d CPU(s), primeira CPU %d",
+            nodes[i].node, nodes[i].cpu_count, nodes[i].cpus[0]);
+    }
+#else
+    logger_log(LOG_WARNING, "Posicionamento de threads: compilado sem libnuma, ignorando");
+#endif
+}
+
+void thread_placement_apply(int worker_index) {
+    if (!placement_enabled || worker_index < 0) return;
+
+#ifdef HAVE_LIBNUMA
+    // Escolhe o nó: round-robin entre os nós ou preenchimento sequencial das CPUs
+    NumaNode *node;
+    int slot;
+    if (placement.numa_spread) {
+        node = &nodes[worker_index % node_count];
+        slot = (worker_index / node_count) % node->cpu_count;
+    } else {
+        int cpu_index = worker_index % total_cpus;
+        int n = 0;
+        while (cpu_index >= nodes[n].cpu_count) {
+            cpu_index -= nodes[n].cpu_count;
+            n++;
+        }
+        node = &nodes[n];
+        slot = cpu_index;
+    }
+
+    if (placement.pin_threads) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(node->cpus[slot], &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            logger_log(LOG_WARNING, "Worker %d: falha ao fixar na CPU %d: %s",
+                worker_index, node->cpus[slot], strerror(rc));
+        } else {
+            logger_log(LOG_INFO, "Worker %d: fixado na CPU %d (nó %d)",
+                worker_index, node->cpus[slot], node->node);
+        }
+    } else if (placement.numa_spread) {
+        if (numa_run_on_node(node->node) != 0) {
+            logger_log(LOG_WARNING, "Worker %d: falha ao restringir ao nó %d", worker_index, node->node);
+        } else {
+            logger_log(LOG_INFO, "Worker %d: restrito ao nó %d", worker_index, node->node);
+        }
+    }
+
+    // Alocações feitas a partir daqui (arena do malloc desta thread, buffers de
+    // leitura e BSON) passam a vir do nó em que a thread está rodando
+    if (placement.numa_local_memory) {
+        numa_set_localalloc();
+    }
+#else
+    (void)worker_index;
+#endif
+}
+
+void thread_placement_cleanup() {
+#ifdef HAVE_LIBNUMA
+    for (int i = 0; i < node_count; i++) {
+        free(nodes[i].cpus);
+    }
+    free(nodes);
+    nodes = NULL;
+    node_count = 0;
+    total_cpus = 0;
+#endif
+    placement_enabled = false;
+}
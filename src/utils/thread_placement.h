@@ -0,0 +1,23 @@
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <stdbool.h>
+
+// Política de posicionamento das threads de processamento
+typedef struct {
+    bool pin_threads;        // Fixa cada thread em um núcleo
+    bool numa_local_memory;  // Mantém buffers e arenas no nó NUMA local da thread
+    bool numa_spread;        // Distribui as threads entre os nós em round-robin
+} ThreadPlacementConfig;
+
+// Lê a topologia da máquina e registra no log a política adotada.
+// Sem libnuma (ou com NUMA indisponível em tempo de execução) vira no-op.
+void thread_placement_init(const ThreadPlacementConfig *config);
+
+// Aplica a política à thread atual; deve ser chamada no início de cada worker
+void thread_placement_apply(int worker_index);
+
+// Libera as estruturas da topologia
+void thread_placement_cleanup();
+
+#endif // THREAD_PLACEMENT_H
@@ -0,0 +1,231 @@
+#include "trace.h"
+
+#ifdef CSV_TRACE
+
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const char *stage_names[TRACE_STAGE_COUNT] = {
+    "read", "decode", "split", "unquote", "build", "insert", "connect"
+};
+
+// Evento de um lote dentro da janela amostrada
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t stage_cycles[TRACE_STAGE_COUNT];
+    int rows;
+} TraceBatch;
+
+// Estado por thread; só a própria thread escreve até o dump final
+typedef struct TraceThread {
+    char name[64];
+    int tid;
+    uint64_t batch_start;
+    uint64_t batch_cycles[TRACE_STAGE_COUNT];
+    uint64_t batch_calls[TRACE_STAGE_COUNT];
+    int batch_rows;
+    int batch_index;
+    uint64_t total_cycles[TRACE_STAGE_COUNT];
+    uint64_t total_calls[TRACE_STAGE_COUNT];
+    long total_rows;
+    TraceBatch *events;
+    int event_count;
+    struct TraceThread *next;
+} TraceThread;
+
+static __thread TraceThread *current = NULL;
+static TraceThread *threads = NULL;
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int next_tid = 1;
+
+static int trace_batch_size = 1000;
+static int trace_window_start = 0;
+static int trace_window_batches = 0;
+static uint64_t origin_cycles = 0;
+static double ns_per_cycle = 1.0;
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t trace_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return monotonic_ns();
+#endif
+}
+
+void trace_init(int batch_size, int window_start, int window_batches) {
+    if (batch_size > 0) trace_batch_size = batch_size;
+    trace_window_start = window_start > 0 ? window_start : 0;
+    trace_window_batches = window_batches > 0 ? window_batches : 0;
+
+    // Converte ciclos em tempo medindo ~20ms de relógio monotônico
+    struct timespec pause = {0, 20000000};
+    uint64_t ns0 = monotonic_ns();
+    uint64_t c0 = trace_now();
+    nanosleep(&pause, NULL);
+    uint64_t ns1 = monotonic_ns();
+    uint64_t c1 = trace_now();
+    if (c1 > c0) ns_per_cycle = (double)(ns1 - ns0) / (double)(c1 - c0);
+    origin_cycles = trace_now();
+
+    logger_log(LOG_INFO, "Trace ativo: lotes de %d linhas, janela de %d lotes a partir do lote %d, %.3f ns/ciclo",
+        trace_batch_size, trace_window_batches, trace_window_start, ns_per_cycle);
+}
+
+void trace_thread_begin(const char *name) {
+    TraceThread *thread = calloc(1, sizeof(TraceThread));
+    if (!thread) return;
+    snprintf(thread->name, sizeof(thread->name), "%s", name ? name : "worker");
+    if (trace_window_batches > 0) {
+        thread->events = calloc(trace_window_batches, sizeof(TraceBatch));
+    }
+    thread->batch_start = trace_now();
+
+    pthread_mutex_lock(&threads_mutex);
+    thread->tid = next_tid++;
+    thread->next = threads;
+    threads = thread;
+    pthread_mutex_unlock(&threads_mutex);
+
+    current = thread;
+}
+
+void trace_add(TraceStage stage, uint64_t cycles) {
+    if (!current) return;
+    current->batch_cycles[stage] += cycles;
+    current->batch_calls[stage]++;
+}
+
+// Consolida o lote corrente e, se estiver na janela, guarda o evento
+static void close_batch(TraceThread *thread) {
+    uint64_t now = trace_now();
+    int window_index = thread->batch_index - trace_window_start;
+
+    if (thread->events && window_index >= 0 && window_index < trace_window_batches) {
+        TraceBatch *event = &thread->events[thread->event_count++];
+        event->start = thread->batch_start;
+        event->end = now;
+        event->rows = thread->batch_rows;
+        memcpy(event->stage_cycles, thread->batch_cycles, sizeof(event->stage_cycles));
+    }
+
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        thread->total_cycles[s] += thread->batch_cycles[s];
+        thread->total_calls[s] += thread->batch_calls[s];
+        thread->batch_cycles[s] = 0;
+        thread->batch_calls[s] = 0;
+    }
+    thread->total_rows += thread->batch_rows;
+    thread->batch_rows = 0;
+    thread->batch_index++;
+    thread->batch_start = now;
+}
+
+void trace_row_end() {
+    if (!current) return;
+    if (++current->batch_rows >= trace_batch_size) {
+        close_batch(current);
+    }
+}
+
+void trace_thread_end() {
+    if (!current) return;
+    bool pending = current->batch_rows > 0;
+    for (int s = 0; s < TRACE_STAGE_COUNT && !pending; s++) {
+        pending = current->batch_calls[s] > 0;
+    }
+    if (pending) close_batch(current);
+    current = NULL;
+}
+
+static double cycles_to_us(uint64_t cycles) {
+    return (double)cycles * ns_per_cycle / 1000.0;
+}
+
+void trace_dump(const char *path) {
+    pthread_mutex_lock(&threads_mutex);
+
+    // Totais agregados de todas as threads
+    uint64_t totals[TRACE_STAGE_COUNT] = {0};
+    uint64_t calls[TRACE_STAGE_COUNT] = {0};
+    long rows = 0;
+    for (TraceThread *t = threads; t; t = t->next) {
+        for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+            totals[s] += t->total_cycles[s];
+            calls[s] += t->total_calls[s];
+        }
+        rows += t->total_rows;
+    }
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        if (calls[s] == 0) continue;
+        logger_log(LOG_INFO, "Trace %-8s: %.3f ms em %llu chamadas (%.3f us/chamada)",
+            stage_names[s], cycles_to_us(totals[s]) / 1000.0, (unsigned long long)calls[s],
+            cycles_to_us(totals[s]) / (double)calls[s]);
+    }
+    logger_log(LOG_INFO, "Trace: %ld linhas instrumentadas", rows);
+
+    FILE *file = (path && path[0]) ? fopen(path, "w") : NULL;
+    if (path && path[0] && !file) {
+        logger_log(LOG_ERROR, "Erro ao criar arquivo de trace: %s", path);
+    }
+
+    if (file) {
+        // Cada lote vira um evento "X"; as etapas são empilhadas dentro dele
+        // na ordem do pipeline, com a soma dos tempos de cada etapa no lote
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        for (TraceThread *t = threads; t; t = t->next) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t->tid, t->name);
+            first = false;
+
+            for (int e = 0; e < t->event_count; e++) {
+                TraceBatch *event = &t->events[e];
+                double ts = cycles_to_us(event->start - origin_cycles);
+                fprintf(file, ",\n{\"name\":\"batch\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"rows\":%d}}",
+                    t->tid, ts, cycles_to_us(event->end - event->start), event->rows);
+
+                double offset = ts;
+                for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+                    if (event->stage_cycles[s] == 0) continue;
+                    double dur = cycles_to_us(event->stage_cycles[s]);
+                    fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        stage_names[s], t->tid, offset, dur);
+                    offset += dur;
+                }
+            }
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        logger_log(LOG_INFO, "Trace gravado em %s", path);
+    }
+
+    while (threads) {
+        TraceThread *next = threads->next;
+        free(threads->events);
+        free(threads);
+        threads = next;
+    }
+    pthread_mutex_unlock(&threads_mutex);
+}
+
+#endif // CSV_TRACE
@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Instrumentação do caminho crítico, ativada em tempo de compilação com
+// `make TRACE=1` (define CSV_TRACE). Sem a flag, todas as macros abaixo
+// se expandem para nada e nenhuma chamada é compilada.
+
+// Etapas medidas por linha
+typedef enum {
+    TRACE_READ,      // Leitura da linha do arquivo
+    TRACE_DECODE,    // Conversão da codificação de entrada para UTF-8
+    TRACE_SPLIT,     // Divisão da linha em campos
+    TRACE_UNQUOTE,   // Remoção de aspas
+    TRACE_BUILD,     // Aplicação do mapeamento e montagem do BSON
+    TRACE_INSERT,    // Chamada de inserção no MongoDB
+    TRACE_CONNECT,   // Criação do cliente MongoDB
+    TRACE_STAGE_COUNT
+} TraceStage;
+
+#ifdef CSV_TRACE
+
+// Calibra o contador de ciclos e define a janela amostrada de cada thread:
+// lotes [window_start, window_start + window_batches) viram eventos no trace
+void trace_init(int batch_size, int window_start, int window_batches);
+
+// Registra a thread atual com um nome para o trace
+void trace_thread_begin(const char *name);
+
+// Fecha o lote parcial da thread atual
+void trace_thread_end();
+
+// Lê o contador de ciclos
+uint64_t trace_now();
+
+// Acumula o tempo de uma etapa no lote corrente da thread
+void trace_add(TraceStage stage, uint64_t cycles);
+
+// Conta uma linha no lote corrente, fechando o lote quando completo
+void trace_row_end();
+
+// Grava o trace no formato Chrome/Perfetto e registra os totais no log
+void trace_dump(const char *path);
+
+#define TRACE_INIT(batch, start, window) trace_init(batch, start, window)
+#define TRACE_THREAD_BEGIN(name) trace_thread_begin(name)
+#define TRACE_THREAD_END() trace_thread_end()
+#define TRACE_BEGIN(stage) uint64_t trace_start_##stage = trace_now()
+#define TRACE_END(stage) trace_add(stage, trace_now() - trace_start_##stage)
+#define TRACE_ROW_END() trace_row_end()
+#define TRACE_DUMP(path) trace_dump(path)
+
+#else
+
+#define TRACE_INIT(batch, start, window) ((void)0)
+#define TRACE_THREAD_BEGIN(name) ((void)0)
+#define TRACE_THREAD_END() ((void)0)
+#define TRACE_BEGIN(stage) ((void)0)
+#define TRACE_END(stage) ((void)0)
+#define TRACE_ROW_END() ((void)0)
+#define TRACE_DUMP(path) ((void)0)
+
+#endif // CSV_TRACE
+
+#endif // TRACE_H
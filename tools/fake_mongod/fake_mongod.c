@@ -0,0 +1,517 @@
+// Servidor MongoDB falso para testes de desempenho ponta a ponta.
+//
+// Implementa apenas o necessário do protocolo para o csv_to_mongo: handshake
+// (OP_QUERY/OP_MSG hello), insert, update, delete e comandos administrativos
+// simples. Conta os documentos recebidos, opcionalmente calcula um checksum
+// independente de ordem e valida o formato, e permite injetar latência e erros.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <getopt.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <bson/bson.h>
+
+#define OP_REPLY 1
+#define OP_QUERY 2004
+#define OP_MSG 2013
+#define MSG_CHECKSUM_PRESENT (1u << 0)
+#define MSG_MORE_TO_COME (1u << 1)
+#define MAX_MESSAGE_SIZE (48 * 1024 * 1024)
+#define MAX_EXPECTED_FIELDS 32
+
+typedef struct {
+    int port;
+    int latency_ms;          // Atraso antes de responder comandos de escrita
+    long error_every;        // Falha um a cada N comandos de escrita (0 = nunca)
+    int error_code;          // Código devolvido nas falhas injetadas
+    bool checksum;           // Calcula checksum dos documentos
+    long expect_docs;        // Documentos esperados ao final (-1 = não verifica)
+    char *expected_fields[MAX_EXPECTED_FIELDS];
+    int expected_field_count;
+} ServerOptions;
+
+static ServerOptions options = { 27017, 0, 0, 11000, false, -1, {0}, 0 };
+
+// Estatísticas globais
+static atomic_long documents_received = 0;
+static atomic_long documents_updated = 0;
+static atomic_long documents_deleted = 0;
+static atomic_long write_commands = 0;
+static atomic_long injected_errors = 0;
+static atomic_long shape_errors = 0;
+static atomic_ullong checksum = 0;
+static atomic_long first_write_ns = 0;
+static atomic_long last_write_ns = 0;
+static atomic_int connection_ids = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static uint64_t fnv1a64(const uint8_t *data, size_t length) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool read_full(int fd, void *buffer, size_t length) {
+    uint8_t *p = buffer;
+    while (length > 0) {
+        ssize_t n = recv(fd, p, length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *buffer, size_t length) {
+    const uint8_t *p = buffer;
+    while (length > 0) {
+        ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static int32_t read_int32(const uint8_t *p) {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write_int32(uint8_t *p, int32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Registra um documento recebido: contagem, checksum e validação de formato
+static void account_document(const bson_t *doc) {
+    atomic_fetch_add(&documents_received, 1);
+
+    if (options.checksum) {
+        // O _id é gerado pelo driver a cada execução: fica fora do checksum
+        bson_t without_id;
+        bson_init(&without_id);
+        bson_copy_to_excluding_noinit(doc, &without_id, "_id", NULL);
+        atomic_fetch_add(&checksum, fnv1a64(bson_get_data(&without_id), without_id.len));
+        bson_destroy(&without_id);
+    }
+
+    for (int i = 0; i < options.expected_field_count; i++) {
+        if (!bson_has_field(doc, options.expected_fields[i])) {
+            atomic_fetch_add(&shape_errors, 1);
+            break;
+        }
+    }
+}
+
+// Conta os documentos de uma sequência (seção tipo 1 do OP_MSG ou array do comando)
+static int count_sequence(const uint8_t *data, size_t length, bool account) {
+    int count = 0;
+    size_t offset = 0;
+    while (offset + 4 <= length) {
+        int32_t doc_length = read_int32(data + offset);
+        if (doc_length < 5 || offset + (size_t)doc_length > length) break;
+        if (account) {
+            bson_t doc;
+            if (bson_init_static(&doc, data + offset, (size_t)doc_length)) account_document(&doc);
+        }
+        offset += (size_t)doc_length;
+        count++;
+    }
+    return count;
+}
+
+static int count_array(const bson_t *command, const char *field, bool account) {
+    bson_iter_t it, child;
+    int count = 0;
+    if (!bson_iter_init_find(&it, command, field) || !BSON_ITER_HOLDS_ARRAY(&it)) return 0;
+    if (!bson_iter_recurse(&it, &child)) return 0;
+    while (bson_iter_next(&child)) {
+        if (account && BSON_ITER_HOLDS_DOCUMENT(&child)) {
+            uint32_t len;
+            const uint8_t *raw;
+            bson_t doc;
+            bson_iter_document(&child, &len, &raw);
+            if (bson_init_static(&doc, raw, len)) account_document(&doc);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void append_hello(bson_t *reply) {
+    BSON_APPEND_BOOL(reply, "helloOk", true);
+    BSON_APPEND_BOOL(reply, "isWritablePrimary", true);
+    BSON_APPEND_BOOL(reply, "ismaster", true);
+    BSON_APPEND_INT32(reply, "maxBsonObjectSize", 16 * 1024 * 1024);
+    BSON_APPEND_INT32(reply, "maxMessageSizeBytes", MAX_MESSAGE_SIZE);
+    BSON_APPEND_INT32(reply, "maxWriteBatchSize", 100000);
+    BSON_APPEND_DATE_TIME(reply, "localTime", (int64_t)time(NULL) * 1000);
+    BSON_APPEND_INT32(reply, "connectionId", atomic_fetch_add(&connection_ids, 1) + 1);
+    BSON_APPEND_INT32(reply, "minWireVersion", 0);
+    BSON_APPEND_INT32(reply, "maxWireVersion", 17);
+    BSON_APPEND_BOOL(reply, "readOnly", false);
+}
+
+// Executa um comando. sequence/sequence_length trazem a seção tipo 1, se houver.
+static void run_command(const bson_t *command, const char *sequence_id, const uint8_t *sequence,
+                        size_t sequence_length, bson_t *reply) {
+    bson_iter_t it;
+    const char *name = "";
+    if (bson_iter_init(&it, command) && bson_iter_next(&it)) name = bson_iter_key(&it);
+
+    bool is_insert = strcmp(name, "insert") == 0;
+    bool is_update = strcmp(name, "update") == 0;
+    bool is_delete = strcmp(name, "delete") == 0;
+
+    if (strcasecmp(name, "hello") == 0 || strcasecmp(name, "isMaster") == 0) {
+        append_hello(reply);
+    } else if (is_insert || is_update || is_delete) {
+        const char *field = is_insert ? "documents" : (is_update ? "updates" : "deletes");
+        long command_number = atomic_fetch_add(&write_commands, 1) + 1;
+        long start = now_ns();
+        long expected = 0;
+        atomic_compare_exchange_strong(&first_write_ns, &expected, start);
+
+        if (options.latency_ms > 0) usleep((useconds_t)options.latency_ms * 1000);
+
+        if (options.error_every > 0 && command_number % options.error_every == 0) {
+            // Simula falha no primeiro documento de um lote ordenado
+            atomic_fetch_add(&injected_errors, 1);
+            bson_t errors, error;
+            BSON_APPEND_INT32(reply, "n", 0);
+            BSON_APPEND_ARRAY_BEGIN(reply, "writeErrors", &errors);
+            BSON_APPEND_DOCUMENT_BEGIN(&errors, "0", &error);
+            BSON_APPEND_INT32(&error, "index", 0);
+            BSON_APPEND_INT32(&error, "code", options.error_code);
+            BSON_APPEND_UTF8(&error, "errmsg", "erro injetado pelo fake_mongod");
+            bson_append_document_end(&errors, &error);
+            bson_append_array_end(reply, &errors);
+        } else {
+            int count;
+            if (sequence && sequence_id && strcmp(sequence_id, field) == 0) {
+                count = count_sequence(sequence, sequence_length, is_insert);
+            } else {
+                count = count_array(command, field, is_insert);
+            }
+            if (is_update) {
+                atomic_fetch_add(&documents_updated, count);
+                BSON_APPEND_INT32(reply, "nModified", count);
+            }
+            if (is_delete) atomic_fetch_add(&documents_deleted, count);
+            BSON_APPEND_INT32(reply, "n", count);
+        }
+        atomic_store(&last_write_ns, now_ns());
+    } else if (strcmp(name, "aggregate") == 0 || strcmp(name, "find") == 0) {
+        // Consultas devolvem sempre um cursor vazio
+        bson_t cursor, batch;
+        BSON_APPEND_DOCUMENT_BEGIN(reply, "cursor", &cursor);
+        BSON_APPEND_INT64(&cursor, "id", 0);
+        BSON_APPEND_UTF8(&cursor, "ns", "fake.fake");
+        BSON_APPEND_ARRAY_BEGIN(&cursor, "firstBatch", &batch);
+        bson_append_array_end(&cursor, &batch);
+        bson_append_document_end(reply, &cursor);
+    } else if (strcmp(name, "ping") != 0 && strcmp(name, "buildInfo") != 0 && strcmp(name, "buildinfo") != 0 &&
+               strcmp(name, "endSessions") != 0 && strcmp(name, "killCursors") != 0 &&
+               strcmp(name, "getLastError") != 0) {
+        BSON_APPEND_DOUBLE(reply, "ok", 0.0);
+        BSON_APPEND_UTF8(reply, "errmsg", "comando não suportado pelo fake_mongod");
+        BSON_APPEND_INT32(reply, "code", 59);
+        return;
+    }
+
+    if (strcmp(name, "buildInfo") == 0 || strcmp(name, "buildinfo") == 0) {
+        BSON_APPEND_UTF8(reply, "version", "6.0.0");
+    }
+    BSON_APPEND_DOUBLE(reply, "ok", 1.0);
+}
+
+static bool send_reply(int fd, int32_t request_id, int32_t op_code, const bson_t *reply) {
+    size_t header = 16 + (op_code == OP_MSG ? 5 : 20);
+    size_t total = header + reply->len;
+    uint8_t *message = malloc(total);
+    if (!message) return false;
+
+    static atomic_int next_id = 1;
+    write_int32(message, (int32_t)total);
+    write_int32(message + 4, atomic_fetch_add(&next_id, 1));
+    write_int32(message + 8, request_id);
+    write_int32(message + 12, op_code);
+
+    if (op_code == OP_MSG) {
+        write_int32(message + 16, 0);   // flagBits
+        message[20] = 0;                // Seção tipo 0
+    } else {
+        write_int32(message + 16, 0);   // responseFlags
+        memset(message + 20, 0, 8);     // cursorID
+        write_int32(message + 28, 0);   // startingFrom
+        write_int32(message + 32, 1);   // numberReturned
+    }
+    memcpy(message + header, bson_get_data(reply), reply->len);
+
+    bool ok = write_full(fd, message, total);
+    free(message);
+    return ok;
+}
+
+static bool handle_op_msg(int fd, int32_t request_id, const uint8_t *body, size_t length) {
+    if (length < 5) return false;
+    uint32_t flags = (uint32_t)read_int32(body);
+    size_t end = length - ((flags & MSG_CHECKSUM_PRESENT) ? 4 : 0);
+    size_t offset = 4;
+
+    bson_t command;
+    bool have_command = false;
+    const char *sequence_id = NULL;
+    const uint8_t *sequence = NULL;
+    size_t sequence_length = 0;
+
+    while (offset < end) {
+        uint8_t kind = body[offset++];
+        if (offset + 4 > end) return false;
+        int32_t section_length = read_int32(body + offset);
+        if (section_length < 5 || offset + (size_t)section_length > end) return false;
+
+        if (kind == 0) {
+            have_command = bson_init_static(&command, body + offset, (size_t)section_length);
+        } else if (kind == 1) {
+            const char *identifier = (const char*)body + offset + 4;
+            size_t id_length = strnlen(identifier, (size_t)section_length - 4);
+            sequence_id = identifier;
+            sequence = body + offset + 4 + id_length + 1;
+            sequence_length = (size_t)section_length - 4 - id_length - 1;
+        }
+        offset += (size_t)section_length;
+    }
+    if (!have_command) return false;
+
+    bson_t reply;
+    bson_init(&reply);
+    run_command(&command, sequence_id, sequence, sequence_length, &reply);
+
+    // Com moreToCome (w:0) o cliente não espera resposta
+    bool ok = (flags & MSG_MORE_TO_COME) ? true : send_reply(fd, request_id, OP_MSG, &reply);
+    bson_destroy(&reply);
+    return ok;
+}
+
+static bool handle_op_query(int fd, int32_t request_id, const uint8_t *body, size_t length) {
+    // flags, fullCollectionName, numberToSkip, numberToReturn, query
+    if (length < 4) return false;
+    size_t offset = 4;
+    size_t name_length = strnlen((const char*)body + offset, length - offset);
+    offset += name_length + 1 + 8;
+    if (offset + 4 > length) return false;
+
+    int32_t doc_length = read_int32(body + offset);
+    bson_t command;
+    if (doc_length < 5 || offset + (size_t)doc_length > length ||
+        !bson_init_static(&command, body + offset, (size_t)doc_length)) return false;
+
+    bson_t reply;
+    bson_init(&reply);
+    run_command(&command, NULL, NULL, 0, &reply);
+    bool ok = send_reply(fd, request_id, OP_REPLY, &reply);
+    bson_destroy(&reply);
+    return ok;
+}
+
+static void *handle_connection(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    uint8_t header[16];
+
+    while (!stop_requested && read_full(fd, header, sizeof(header))) {
+        int32_t length = read_int32(header);
+        int32_t request_id = read_int32(header + 4);
+        int32_t op_code = read_int32(header + 12);
+        if (length < 16 || length > MAX_MESSAGE_SIZE) break;
+
+        size_t body_length = (size_t)length - 16;
+        if (body_length > capacity) {
+            uint8_t *grown = realloc(buffer, body_length);
+            if (!grown) break;
+            buffer = grown;
+            capacity = body_length;
+        }
+        if (!read_full(fd, buffer, body_length)) break;
+
+        bool ok;
+        if (op_code == OP_MSG) {
+            ok = handle_op_msg(fd, request_id, buffer, body_length);
+        } else if (op_code == OP_QUERY) {
+            ok = handle_op_query(fd, request_id, buffer, body_length);
+        } else {
+            fprintf(stderr, "fake_mongod: opcode %d não suportado\n", op_code);
+            ok = false;
+        }
+        if (!ok) break;
+    }
+
+    free(buffer);
+    close(fd);
+    return NULL;
+}
+
+// Imprime o resumo e retorna 0 se as expectativas foram atendidas
+static int print_summary() {
+    long docs = atomic_load(&documents_received);
+    long first = atomic_load(&first_write_ns);
+    long last = atomic_load(&last_write_ns);
+    double seconds = (first > 0 && last > first) ? (double)(last - first) / 1e9 : 0.0;
+
+    printf("\nfake_mongod: estatísticas\n");
+    printf("Documentos inseridos: %ld\n", docs);
+    printf("Documentos atualizados: %ld\n", atomic_load(&documents_updated));
+    printf("Documentos removidos: %ld\n", atomic_load(&documents_deleted));
+    printf("Comandos de escrita: %ld\n", atomic_load(&write_commands));
+    printf("Erros injetados: %ld\n", atomic_load(&injected_errors));
+    if (options.checksum) {
+        printf("Checksum: %016llx\n", (unsigned long long)atomic_load(&checksum));
+    }
+    if (options.expected_field_count > 0) {
+        printf("Documentos com formato inválido: %ld\n", atomic_load(&shape_errors));
+    }
+    if (seconds > 0) {
+        printf("Vazão: %.0f documentos/s em %.2f s\n", (double)docs / seconds, seconds);
+    }
+    fflush(stdout);
+
+    int status = 0;
+    if (options.expect_docs >= 0 && docs != options.expect_docs) {
+        fprintf(stderr, "fake_mongod: esperados %ld documentos, recebidos %ld\n", options.expect_docs, docs);
+        status = 1;
+    }
+    if (atomic_load(&shape_errors) > 0) status = 1;
+    return status;
+}
+
+static void handle_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+        "Uso: %s [opções]\n"
+        "  --port N            Porta TCP (padrão 27017)\n"
+        "  --latency-ms N      Atraso por comando de escrita\n"
+        "  --error-every N     Falha um a cada N comandos de escrita\n"
+        "  --error-code N      Código das falhas injetadas (padrão 11000)\n"
+        "  --checksum          Calcula checksum independente de ordem dos documentos\n"
+        "  --expect-docs N     Sai com erro se o total de documentos for diferente\n"
+        "  --expect-fields L   Campos obrigatórios em cada documento (separados por vírgula)\n"
+        "Encerre com SIGINT/SIGTERM para imprimir o resumo.\n", program);
+}
+
+int main(int argc, char **argv) {
+    static struct option long_options[] = {
+        {"port", required_argument, 0, 'p'},
+        {"latency-ms", required_argument, 0, 'l'},
+        {"error-every", required_argument, 0, 'e'},
+        {"error-code", required_argument, 0, 'c'},
+        {"checksum", no_argument, 0, 's'},
+        {"expect-docs", required_argument, 0, 'd'},
+        {"expect-fields", required_argument, 0, 'f'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:l:e:c:sd:f:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': options.port = atoi(optarg); break;
+            case 'l': options.latency_ms = atoi(optarg); break;
+            case 'e': options.error_every = atol(optarg); break;
+            case 'c': options.error_code = atoi(optarg); break;
+            case 's': options.checksum = true; break;
+            case 'd': options.expect_docs = atol(optarg); break;
+            case 'f': {
+                char *list = strdup(optarg);
+                for (char *field = strtok(list, ","); field && options.expected_field_count < MAX_EXPECTED_FIELDS;
+                     field = strtok(NULL, ",")) {
+                    options.expected_fields[options.expected_field_count++] = field;
+                }
+                break;
+            }
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        perror("socket");
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)options.port);
+    if (bind(server, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(server, 128) != 0) {
+        perror("bind/listen");
+        close(server);
+        return 1;
+    }
+
+    // Sem SA_RESTART: o accept é interrompido pelo sinal e o laço termina
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("fake_mongod: escutando em 127.0.0.1:%d\n", options.port);
+    fflush(stdout);
+
+    while (!stop_requested) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            break;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, handle_connection, (void*)(intptr_t)client) != 0) {
+            close(client);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    close(server);
+    return print_summary();
+}
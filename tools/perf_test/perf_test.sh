@@ -0,0 +1,113 @@
+#!/bin/sh
+# Teste de desempenho ponta a ponta: gera arquivos pagina_NNNN.csv, sobe o
+# fake_mongod esperando o total de documentos e o formato, roda o
+# csv_to_mongo real contra ele e informa linhas/s. Sai com erro se o
+# importador falhar ou se o fake_mongod não receber o que era esperado.
+#
+# Uso: perf_test.sh [arquivos] [linhas por arquivo] [porta]
+
+set -u
+
+FILES=${1:-4}
+ROWS=${2:-100000}
+PORT=${3:-27999}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+IMPORTER="$ROOT/bin/csv_to_mongo"
+FAKE_MONGOD="$ROOT/bin/fake_mongod"
+TOTAL=$((FILES * ROWS))
+
+for binary in "$IMPORTER" "$FAKE_MONGOD"; do
+    if [ ! -x "$binary" ]; then
+        echo "perf-test: $binary não encontrado (rode make all fake_mongod)" >&2
+        exit 1
+    fi
+done
+
+WORK=$(mktemp -d)
+FAKE_PID=""
+cleanup() {
+    if [ -n "$FAKE_PID" ]; then kill -TERM "$FAKE_PID" 2>/dev/null; fi
+    rm -rf "$WORK"
+}
+trap cleanup EXIT INT TERM
+
+# Diretório de trabalho com o layout que o importador espera
+mkdir -p "$WORK/config" "$WORK/files_csv"
+cp "$ROOT/config/field_mapping.json" "$WORK/config/"
+cat > "$WORK/config/config.json" <<JSON
+{
+	"mongodb_host": "127.0.0.1",
+	"mongodb_port": $PORT,
+	"mongodb_database": "perf_test",
+	"mongodb_collection": "pessoas",
+	"mongodb_username": "",
+	"mongodb_password": "",
+	"incremental": false,
+	"verify": false,
+	"rejects_dir": "rejects"
+}
+JSON
+
+# 36 colunas, como no mapeamento padrão (cpf na 2ª, nome na 3ª, telefones de 22 a 35, email na 36ª)
+echo "perf-test: gerando $FILES arquivos com $ROWS linhas"
+i=1
+while [ "$i" -le "$FILES" ]; do
+    awk -v rows="$ROWS" -v file="$i" 'BEGIN {
+        header = "id"
+        for (c = 2; c <= 36; c++) header = header ";col" c
+        print header
+        for (r = 1; r <= rows; r++) {
+            line = r ";" sprintf("%05d%06d", file, r) ";NOME " file " " r
+            for (c = 4; c <= 21; c++) line = line ";valor" c
+            line = line ";11 9" sprintf("%08d", r) ";31 3" sprintf("%07d", r)
+            for (c = 24; c <= 35; c++) line = line ";"
+            line = line ";pessoa" r "@exemplo.com"
+            print line
+        }
+    }' > "$WORK/files_csv/$(printf 'pagina_%04d.csv' "$i")"
+    i=$((i + 1))
+done
+
+"$FAKE_MONGOD" --port "$PORT" --expect-docs "$TOTAL" --expect-fields cpf,nome,contatos > "$WORK/fake_mongod.log" 2>&1 &
+FAKE_PID=$!
+
+# Aguarda o fake_mongod abrir a porta
+tries=0
+until grep -q "escutando" "$WORK/fake_mongod.log" 2>/dev/null; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 50 ] || ! kill -0 "$FAKE_PID" 2>/dev/null; then
+        echo "perf-test: fake_mongod não iniciou" >&2
+        cat "$WORK/fake_mongod.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+start=$(date +%s%N)
+(cd "$WORK" && "$IMPORTER") > "$WORK/csv_to_mongo.log" 2>&1
+importer_status=$?
+end=$(date +%s%N)
+
+# SIGTERM faz o fake_mongod imprimir o resumo e conferir total e formato
+# (processos em segundo plano de um shell não interativo ignoram SIGINT)
+kill -TERM "$FAKE_PID"
+wait "$FAKE_PID"
+fake_status=$?
+FAKE_PID=""
+
+cat "$WORK/csv_to_mongo.log"
+cat "$WORK/fake_mongod.log"
+
+elapsed_ms=$(( (end - start) / 1000000 ))
+if [ "$elapsed_ms" -le 0 ]; then elapsed_ms=1; fi
+echo "perf-test: $TOTAL linhas em $elapsed_ms ms ($((TOTAL * 1000 / elapsed_ms)) linhas/s)"
+
+if [ "$importer_status" -ne 0 ]; then
+    echo "perf-test: csv_to_mongo terminou com código $importer_status" >&2
+    exit 1
+fi
+if [ "$fake_status" -ne 0 ]; then
+    echo "perf-test: total de documentos ou formato não confere (fake_mongod código $fake_status)" >&2
+    exit 1
+fi
+echo "perf-test: ok"